@@ -0,0 +1,127 @@
+#include "headlessbackend.h"
+#include "rowindex.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+// Checks that pointer events don't allocate: hit testing and simulating a drop, like every pointer motion does
+// while a gridded view is dragged, run with zero malloc, realloc or free calls once the scratch space has grown.
+// The allocator is wrapped with the linker's --wrap, see CMakeLists.txt.
+
+#define OUTPUT_WIDTH 1920
+#define OUTPUT_HEIGHT 1080
+#define VIEW_WIDTH 800
+#define VIEW_HEIGHT 600
+#define WINDOWS_PER_ROW 3
+#define EVENT_COUNT 10000
+
+static const size_t windowCounts[] = {10, 1000};
+
+// allocator
+
+static size_t allocationCount = 0;
+
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t count, size_t size);
+void* __real_realloc(void* pointer, size_t size);
+void __real_free(void* pointer);
+
+void* __wrap_malloc(size_t const size) {
+    allocationCount++;
+    return __real_malloc(size);
+}
+
+void* __wrap_calloc(size_t const count, size_t const size) {
+    allocationCount++;
+    return __real_calloc(count, size);
+}
+
+void* __wrap_realloc(void* const pointer, size_t const size) {
+    allocationCount++;
+    return __real_realloc(pointer, size);
+}
+
+void __wrap_free(void* const pointer) {
+    if (pointer != NULL) {
+        allocationCount++;
+    }
+    __real_free(pointer);
+}
+
+// events
+
+static uint32_t randomState;
+
+static uint32_t nextRandom() {
+    // xorshift, reseeded by runPointerEvents
+    randomState ^= randomState << 13;
+    randomState ^= randomState >> 17;
+    randomState ^= randomState << 5;
+    return randomState;
+}
+
+// what a pointer motion does: hit test the edges, and while dragging simulate dropping the moved view
+static void runPointerEvents(wlc_handle const output, const wlc_handle* const views, size_t const viewCount,
+                             struct ShadowLayout* const shadow) {
+    struct Grid* const grid = getGrid(output);
+    randomState = 2463534242;
+    for (size_t i = 0; i < EVENT_COUNT; i++) {
+        headlessSetPointer(nextRandom() % OUTPUT_WIDTH, nextRandom() % OUTPUT_HEIGHT);
+        getExactEdge(grid);
+        struct Edge const edge = getNearestEdge(grid);
+        wlc_handle const movedView = views[nextRandom() % viewCount];
+        if (edge.type != EDGE_NONE && !doesEdgeBelongToView(&edge, movedView)) {
+            simulateMoveViewToEdge(movedView, &edge, shadow);
+        }
+    }
+}
+
+static bool checkWindowCount(size_t const windowCount) {
+    wlc_handle const output = headlessCreateOutput((struct GridSize){OUTPUT_WIDTH, OUTPUT_HEIGHT});
+    struct Grid* const grid = getGrid(output);
+    wlc_handle* const views = malloc(windowCount * sizeof(wlc_handle));
+    for (size_t i = 0; i < windowCount; i++) {
+        views[i] = headlessCreateView(output, (struct GridSize){VIEW_WIDTH, VIEW_HEIGHT}, 0, true);
+        if (i % WINDOWS_PER_ROW != 0) {
+            struct Row* const prevRow = grid->lastRow->prev;
+            struct Edge edge = {EDGE_WINDOW, prevRow, prevRow->lastWindow};
+            moveViewToEdge(views[i], &edge);
+        }
+    }
+    scrollGrid(grid, rowIndexGetLength(grid) / 2.0);
+    headlessRender();
+
+    // the first pass grows the scratch space, the same events again must not allocate
+    struct ShadowLayout shadow = EMPTY_SHADOW_LAYOUT;
+    runPointerEvents(output, views, windowCount, &shadow);
+    size_t const before = allocationCount;
+    runPointerEvents(output, views, windowCount, &shadow);
+    size_t const allocations = allocationCount - before;
+    printf("%7zu windows  %zu pointer events  %zu allocations\n", windowCount, (size_t)EVENT_COUNT, allocations);
+
+    freeShadowLayout(&shadow);
+    for (size_t i = 0; i < windowCount; i++) {
+        headlessDestroyView(views[i]);
+    }
+    headlessDestroyOutput(output);
+    free(views);
+    return allocations == 0;
+}
+
+int main(void) {
+    headless_init();
+    grid_init(&headlessBackend);
+
+    bool allocationFree = true;
+    for (size_t i = 0; i < sizeof(windowCounts) / sizeof(windowCounts[0]); i++) {
+        allocationFree = checkWindowCount(windowCounts[i]) && allocationFree;
+    }
+
+    headless_free();
+    grid_free();
+    if (!allocationFree) {
+        fprintf(stderr, "pointer events allocated\n");
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
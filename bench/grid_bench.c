@@ -0,0 +1,354 @@
+#include "headlessbackend.h"
+#include "rowindex.h"
+
+#include <linux/perf_event.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+// Times the grid's hot paths on grids of different sizes against the headless backend.
+// Every sample includes the layout flush of the frame that follows the operation.
+
+#define OUTPUT_WIDTH 1920
+#define OUTPUT_HEIGHT 1080
+#define VIEW_WIDTH 800
+#define VIEW_HEIGHT 600
+#define WINDOWS_PER_ROW 3
+#define SAMPLE_COUNT 1000
+#define LAYOUT_WINDOW_COUNT 10000
+#define LAYOUT_PASS_COUNT 50
+
+static const size_t windowCounts[] = {10, 100, 1000, 10000};
+
+static uint32_t nextRandom() {
+    // xorshift, seeded the same every run so runs are comparable
+    static uint32_t state = 2463534242;
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+static uint64_t now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+// benchmark state
+
+static wlc_handle output;
+static wlc_handle* views = NULL;
+static size_t viewCount = 0;
+
+static uint64_t samples[SAMPLE_COUNT];
+static size_t sampleCount;
+static uint64_t sampleStart;
+static struct GeometryStats statsBefore;
+
+static void beginOperation() {
+    sampleCount = 0;
+    statsBefore = geometryStats;
+}
+
+static void beginSample() {
+    sampleStart = now();
+}
+
+static void endSample() {
+    headlessRender();
+    samples[sampleCount++] = now() - sampleStart;
+}
+
+static int compareSamples(const void* a, const void* b) {
+    uint64_t const sa = *(const uint64_t*)a;
+    uint64_t const sb = *(const uint64_t*)b;
+    return (sa > sb) - (sa < sb);
+}
+
+static uint64_t getPercentile(unsigned const percentile) {
+    return samples[(sampleCount - 1) * percentile / 100];
+}
+
+static void reportOperation(size_t const windowCount, const char* const name) {
+    qsort(samples, sampleCount, sizeof(uint64_t), &compareSamples);
+    double const geometries = (double)(geometryStats.geometriesSent - statsBefore.geometriesSent) / sampleCount;
+    double const masks = (double)(geometryStats.masksSent - statsBefore.masksSent) / sampleCount;
+    double const suppressed = (double)(geometryStats.geometriesSuppressed - statsBefore.geometriesSuppressed +
+                                       geometryStats.masksSuppressed - statsBefore.masksSuppressed) / sampleCount;
+    printf("%7zu  %-15s %9lu %9lu %9lu %9lu %10.1f %8.1f %10.1f\n", windowCount, name,
+           (unsigned long)getPercentile(50), (unsigned long)getPercentile(90),
+           (unsigned long)getPercentile(99), (unsigned long)samples[sampleCount - 1],
+           geometries, masks, suppressed);
+}
+
+static wlc_handle getRandomView() {
+    return views[nextRandom() % viewCount];
+}
+
+static struct Window* getRandomWindow() {
+    return getWindow(getRandomView());
+}
+
+static void addView() {
+    views[viewCount++] = headlessCreateView(output, (struct GridSize){VIEW_WIDTH, VIEW_HEIGHT}, 0, true);
+}
+
+static void removeView(size_t const i) {
+    headlessDestroyView(views[i]);
+    views[i] = views[--viewCount];
+}
+
+// fills the grid with windowCount windows, WINDOWS_PER_ROW to a row
+static void fillGrid(size_t const windowCount) {
+    struct Grid* const grid = getGrid(output);
+    for (size_t i = 0; i < windowCount; i++) {
+        addView();
+        if (i % WINDOWS_PER_ROW != 0) {
+            struct Row* const prevRow = grid->lastRow->prev;
+            struct Edge edge = {EDGE_WINDOW, prevRow, prevRow->lastWindow};
+            moveViewToEdge(views[viewCount - 1], &edge);
+        }
+    }
+    headlessRender();
+}
+
+static void removeAllViews() {
+    while (viewCount > 0) {
+        removeView(viewCount - 1);
+    }
+    headlessRender();
+}
+
+// operations
+
+static void benchCreateDestroyWindow(size_t const windowCount) {
+    size_t const firstNew = viewCount;
+    beginOperation();
+    for (size_t i = 0; i < SAMPLE_COUNT; i++) {
+        beginSample();
+        addView();
+        endSample();
+    }
+    reportOperation(windowCount, "createWindow");
+
+    beginOperation();
+    while (viewCount > firstNew) {
+        size_t const i = firstNew + nextRandom() % (viewCount - firstNew);
+        beginSample();
+        removeView(i);
+        endSample();
+    }
+    reportOperation(windowCount, "destroyWindow");
+}
+
+static void benchMoveViewToEdge(size_t const windowCount) {
+    struct Grid* const grid = getGrid(output);
+    beginOperation();
+    while (sampleCount < SAMPLE_COUNT) {
+        wlc_handle const view = getRandomView();
+        struct Row* const targetRow = rowIndexGetAt(grid, nextRandom() % rowIndexGetCount(grid));
+        // alternate between joining rows and creating rows, so the shape of the grid stays about the same
+        struct Edge edge = sampleCount % 2 == 0 ? (struct Edge){EDGE_WINDOW, targetRow, targetRow->lastWindow}
+                                                : (struct Edge){EDGE_ROW, targetRow, NULL};
+        if (doesEdgeBelongToView(&edge, view)) {
+            continue;
+        }
+        beginSample();
+        moveViewToEdge(view, &edge);
+        endSample();
+    }
+    reportOperation(windowCount, "moveViewToEdge");
+}
+
+static void benchSimulateMoveViewToEdge(size_t const windowCount) {
+    struct Grid* const grid = getGrid(output);
+    struct ShadowLayout shadow = EMPTY_SHADOW_LAYOUT;
+    beginOperation();
+    while (sampleCount < SAMPLE_COUNT) {
+        wlc_handle const view = getRandomView();
+        struct Row* const targetRow = rowIndexGetAt(grid, nextRandom() % rowIndexGetCount(grid));
+        struct Edge edge = sampleCount % 2 == 0 ? (struct Edge){EDGE_WINDOW, targetRow, targetRow->lastWindow}
+                                                : (struct Edge){EDGE_ROW, targetRow, NULL};
+        if (doesEdgeBelongToView(&edge, view)) {
+            continue;
+        }
+        beginSample();
+        simulateMoveViewToEdge(view, &edge, &shadow);
+        endSample();
+    }
+    reportOperation(windowCount, "simulateDrop");
+    freeShadowLayout(&shadow);
+}
+
+static void benchMoveRowForward(size_t const windowCount) {
+    beginOperation();
+    for (size_t i = 0; i < SAMPLE_COUNT; i++) {
+        wlc_handle const view = getRandomView();
+        beginSample();
+        moveRowForward(view);
+        endSample();
+    }
+    reportOperation(windowCount, "moveRowForward");
+}
+
+static void benchResizeRow(size_t const windowCount) {
+    beginOperation();
+    for (size_t i = 0; i < SAMPLE_COUNT; i++) {
+        struct Row* const row = getRandomWindow()->parent;
+        int32_t const delta = i % 2 == 0 ? 16 : -16;
+        beginSample();
+        resizeRow(row, delta);
+        endSample();
+    }
+    reportOperation(windowCount, "resizeRow");
+}
+
+static void benchResizeWindow(size_t const windowCount) {
+    beginOperation();
+    for (size_t i = 0; i < SAMPLE_COUNT; i++) {
+        struct Window* const window = getRandomWindow();
+        int32_t const delta = i % 2 == 0 ? 16 : -16;
+        beginSample();
+        resizeWindow(window, delta);
+        endSample();
+    }
+    reportOperation(windowCount, "resizeWindow");
+}
+
+static void benchScrollGrid(size_t const windowCount) {
+    struct Grid* const grid = getGrid(output);
+    double amount = 37.5;
+    beginOperation();
+    for (size_t i = 0; i < SAMPLE_COUNT; i++) {
+        double const scrollBefore = grid->scroll;
+        beginSample();
+        scrollGrid(grid, amount);
+        endSample();
+        if (grid->scroll == scrollBefore) {
+            // reached an end, turn around
+            amount = -amount;
+        }
+    }
+    reportOperation(windowCount, "scrollGrid");
+}
+
+static void benchGetNearestEdge(size_t const windowCount) {
+    struct Grid* const grid = getGrid(output);
+    uint32_t edgesFound = 0;
+    beginOperation();
+    for (size_t i = 0; i < SAMPLE_COUNT; i++) {
+        headlessSetPointer(nextRandom() % OUTPUT_WIDTH, nextRandom() % OUTPUT_HEIGHT);
+        beginSample();
+        struct Edge const edge = getNearestEdge(grid);
+        endSample();
+        edgesFound += edge.type != EDGE_NONE;
+    }
+    reportOperation(windowCount, "getNearestEdge");
+    if (edgesFound == 0) {
+        fprintf(stderr, "getNearestEdge found no edges\n");
+    }
+}
+
+// layout passes
+
+// hardware cache misses of this process, -1 if the kernel doesn't let us count them
+static int openCacheMissCounter() {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = PERF_COUNT_HW_CACHE_MISSES;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+// lays out and flushes every row of the grid, walking all rows and windows in grid order
+static void layoutAllRows(struct Grid* const grid) {
+    for (struct Row* row = grid->firstRow; row != NULL; row = row->next) {
+        layoutRow(row);
+    }
+}
+
+static void benchLayoutPass(const char* const name) {
+    struct Grid* const grid = getGrid(output);
+    int const counter = openCacheMissCounter();
+    uint64_t cacheMisses = 0;
+    beginOperation();
+    for (size_t i = 0; i < LAYOUT_PASS_COUNT; i++) {
+        if (counter >= 0) {
+            ioctl(counter, PERF_EVENT_IOC_RESET, 0);
+            ioctl(counter, PERF_EVENT_IOC_ENABLE, 0);
+        }
+        beginSample();
+        layoutAllRows(grid);
+        endSample();
+        if (counter >= 0) {
+            ioctl(counter, PERF_EVENT_IOC_DISABLE, 0);
+            uint64_t count;
+            if (read(counter, &count, sizeof(count)) == sizeof(count)) {
+                cacheMisses += count;
+            }
+        }
+    }
+    reportOperation(LAYOUT_WINDOW_COUNT, name);
+    if (counter >= 0) {
+        printf("%7s  %-15s %9lu cache misses per pass\n", "", name, (unsigned long)(cacheMisses / LAYOUT_PASS_COUNT));
+        close(counter);
+    }
+}
+
+// Compares layout passes over a grid whose rows and windows were allocated in grid order, so that they're
+// adjacent in the pools, with the same grid allocated after churn left the pools' free lists in random order,
+// so that neighbors in the grid are scattered over the slabs like malloc'd records on a long running heap.
+// Must run first, while the pools are still fresh.
+static void benchLayoutLocality() {
+    fillGrid(LAYOUT_WINDOW_COUNT);
+    benchLayoutPass("layoutPooled");
+    removeAllViews();
+
+    fillGrid(LAYOUT_WINDOW_COUNT);
+    while (viewCount > 0) {
+        removeView(nextRandom() % viewCount);
+    }
+    headlessRender();
+    fillGrid(LAYOUT_WINDOW_COUNT);
+    benchLayoutPass("layoutScattered");
+    removeAllViews();
+}
+
+int main(void) {
+    headless_init();
+    grid_init(&headlessBackend);
+    output = headlessCreateOutput((struct GridSize){OUTPUT_WIDTH, OUTPUT_HEIGHT});
+
+    size_t const maxWindowCount = windowCounts[sizeof(windowCounts) / sizeof(windowCounts[0]) - 1];
+    views = malloc((maxWindowCount + SAMPLE_COUNT) * sizeof(wlc_handle));
+
+    printf("windows  operation          p50 ns    p90 ns    p99 ns    max ns  geoms/op masks/op  skipped/op\n");
+    benchLayoutLocality();
+    for (size_t i = 0; i < sizeof(windowCounts) / sizeof(windowCounts[0]); i++) {
+        size_t const windowCount = windowCounts[i];
+        fillGrid(windowCount);
+        benchCreateDestroyWindow(windowCount);
+        benchMoveViewToEdge(windowCount);
+        benchSimulateMoveViewToEdge(windowCount);
+        benchMoveRowForward(windowCount);
+        benchResizeRow(windowCount);
+        benchResizeWindow(windowCount);
+        benchScrollGrid(windowCount);
+        benchGetNearestEdge(windowCount);
+        removeAllViews();
+    }
+
+    free(views);
+    headless_free();
+    grid_free();
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,148 @@
+#include "headlessbackend.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Checks the two properties the row layout promises: the windows of a row that's distributed (always with
+// grid_minimizeEmptySpace, otherwise when their preferred sizes don't fit) add up to exactly the row's length,
+// and laying out the same windows again gives the same sizes, in both orientations.
+
+#define OUTPUT_WIDTH 1920
+#define OUTPUT_HEIGHT 1080
+#define ROW_COUNT 200
+#define MAX_WINDOWS_PER_ROW 7
+#define RELAYOUT_COUNT 3
+
+static uint32_t randomState;
+
+static uint32_t nextRandom() {
+    // xorshift, reseeded by checkLayout
+    randomState ^= randomState << 13;
+    randomState ^= randomState >> 17;
+    randomState ^= randomState << 5;
+    return randomState;
+}
+
+// fills the grid with rows of 1 to MAX_WINDOWS_PER_ROW windows of random sizes, returns the window count
+static size_t fillGrid(wlc_handle const output, uint32_t const minSize, uint32_t const maxSize) {
+    struct Grid* const grid = getGrid(output);
+    size_t windowCount = 0;
+    for (size_t r = 0; r < ROW_COUNT; r++) {
+        size_t const rowWindowCount = 1 + nextRandom() % MAX_WINDOWS_PER_ROW;
+        for (size_t i = 0; i < rowWindowCount; i++) {
+            struct GridSize const size = {minSize + nextRandom() % (maxSize - minSize),
+                                          minSize + nextRandom() % (maxSize - minSize)};
+            wlc_handle const view = headlessCreateView(output, size, 0, true);
+            if (i > 0) {
+                struct Row* const prevRow = grid->lastRow->prev;
+                struct Edge edge = {EDGE_WINDOW, prevRow, prevRow->lastWindow};
+                moveViewToEdge(view, &edge);
+            }
+        }
+        windowCount += rowWindowCount;
+    }
+    return windowCount;
+}
+
+static bool checkRowLengths(wlc_handle const output) {
+    uint64_t const maxRowLength = getMaxRowLength(output);
+    for (const struct Row* row = getGrid(output)->firstRow; row != NULL; row = row->next) {
+        uint64_t length = 0;
+        uint64_t preferredLength = 0;
+        size_t count = 0;
+        for (const struct Window* window = row->firstWindow; window != NULL; window = window->next) {
+            length += window->size + grid_windowSpacing;
+            preferredLength += getWindowPreferredSize(window) + grid_windowSpacing;
+            count++;
+        }
+        if (count != row->windowCount) {
+            fprintf(stderr, "row has %zu windows, but counts %zu\n", count, row->windowCount);
+            return false;
+        }
+        bool const distributed = grid_minimizeEmptySpace || preferredLength > maxRowLength;
+        if (distributed && length != maxRowLength) {
+            fprintf(stderr, "row of %zu windows is %lu long instead of %lu\n", count, (unsigned long)length,
+                    (unsigned long)maxRowLength);
+            return false;
+        }
+    }
+    return true;
+}
+
+// rebuilds the grid from its own arrangement, which lays out every row again
+static void relayoutGrid(struct Grid* const grid, struct Window** const windows, size_t* const rowWindowCounts,
+                         uint32_t* const rowSizes) {
+    size_t windowCount = 0;
+    size_t rowCount = 0;
+    for (const struct Row* row = grid->firstRow; row != NULL; row = row->next) {
+        rowWindowCounts[rowCount] = 0;
+        rowSizes[rowCount] = row->size;
+        for (struct Window* window = row->firstWindow; window != NULL; window = window->next) {
+            windows[windowCount++] = window;
+            rowWindowCounts[rowCount]++;
+        }
+        rowCount++;
+    }
+    rebuildGrid(grid, windows, rowWindowCounts, rowSizes, rowCount, grid->scroll);
+}
+
+static void getWindowSizes(const struct Grid* const grid, uint32_t* const sizes) {
+    size_t i = 0;
+    for (const struct Row* row = grid->firstRow; row != NULL; row = row->next) {
+        for (const struct Window* window = row->firstWindow; window != NULL; window = window->next) {
+            sizes[i++] = window->size;
+        }
+    }
+}
+
+static bool checkLayout(bool const minimizeEmptySpace, uint32_t const minSize, uint32_t const maxSize) {
+    grid_minimizeEmptySpace = minimizeEmptySpace;
+    randomState = 2463534242;
+    wlc_handle const output = headlessCreateOutput((struct GridSize){OUTPUT_WIDTH, OUTPUT_HEIGHT});
+    struct Grid* const grid = getGrid(output);
+    size_t const windowCount = fillGrid(output, minSize, maxSize);
+
+    struct Window** const windows = malloc(windowCount * sizeof(struct Window*));
+    size_t* const rowWindowCounts = malloc(ROW_COUNT * sizeof(size_t));
+    uint32_t* const rowSizes = malloc(ROW_COUNT * sizeof(uint32_t));
+    uint32_t* const sizes = malloc(windowCount * sizeof(uint32_t));
+    uint32_t* const relayoutSizes = malloc(windowCount * sizeof(uint32_t));
+
+    bool ok = checkRowLengths(output);
+    getWindowSizes(grid, sizes);
+    for (size_t i = 0; i < RELAYOUT_COUNT && ok; i++) {
+        relayoutGrid(grid, windows, rowWindowCounts, rowSizes);
+        getWindowSizes(grid, relayoutSizes);
+        if (memcmp(sizes, relayoutSizes, windowCount * sizeof(uint32_t)) != 0) {
+            fprintf(stderr, "relayout %zu changed window sizes\n", i + 1);
+            ok = false;
+        }
+        ok = ok && checkRowLengths(output);
+    }
+    printf("%-10s minimizeEmptySpace %d  views %4u-%4u  %zu windows  %s\n", grid_horizontal ? "horizontal" : "vertical",
+           minimizeEmptySpace, minSize, maxSize, windowCount, ok ? "ok" : "FAILED");
+
+    free(windows);
+    free(rowWindowCounts);
+    free(rowSizes);
+    free(sizes);
+    free(relayoutSizes);
+    headlessDestroyOutput(output);
+    return ok;
+}
+
+int main(void) {
+    bool ok = true;
+    for (int horizontal = 1; horizontal >= 0; horizontal--) {
+        grid_horizontal = horizontal;
+        headless_init();
+        grid_init(&headlessBackend);
+        ok = checkLayout(true, 50, 900) && ok;
+        ok = checkLayout(false, 50, 150) && ok;   // fit, so they keep their preferred sizes
+        ok = checkLayout(false, 300, 900) && ok;  // overflow, so they're distributed
+        headless_free();
+        grid_free();
+    }
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,341 @@
+#include "gridcommand.h"
+#include "griddrag.h"
+#include "headlessbackend.h"
+#include "traceformat.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Replays a trace recorded with ENDLESSWM_TRACE against the headless backend and reports how long each
+// kind of event takes to process, next to how long it took in the recorded session.
+// Only the grid's side of the callbacks is replayed: output and view lifecycle, pointer hit testing,
+// dragging gridded views and edges, grid commands, scrolling and layout flushes. Pointer events drive
+// griddrag.c and commands run through gridcommand.c, the same code the compositor runs.
+// Keys are counted, but not dispatched, since what they do depends on the keybindings of the recorded
+// session: the grid commands they ran are recorded as events of their own.
+
+#define SLOWEST_EVENT_COUNT 10
+
+static const char* const eventTypeNames[TRACE_EVENT_TYPE_COUNT] = {
+    "outputCreated",
+    "outputDestroyed",
+    "viewCreated",
+    "viewDestroyed",
+    "key",
+    "pointerButton",
+    "pointerMotion",
+    "pointerScroll",
+    "frame",
+    "command",
+};
+
+static uint64_t now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+// recorded handles to headless handles
+
+struct HandleMap {
+    wlc_handle* handles;
+    size_t size;
+};
+
+static struct HandleMap outputMap = {NULL, 0};
+static struct HandleMap viewMap = {NULL, 0};
+
+static wlc_handle getMapped(const struct HandleMap* const map, uint32_t const recorded) {
+    return recorded < map->size ? map->handles[recorded] : 0;
+}
+
+static void setMapped(struct HandleMap* const map, uint32_t const recorded, wlc_handle const handle) {
+    if (recorded >= map->size) {
+        size_t const oldSize = map->size;
+        map->size = (recorded + 1) * 2;
+        map->handles = realloc(map->handles, map->size * sizeof(wlc_handle));
+        memset(map->handles + oldSize, 0, (map->size - oldSize) * sizeof(wlc_handle));
+    }
+    map->handles[recorded] = handle;
+}
+
+// timings
+
+struct Timings {
+    uint64_t* replayed;
+    uint64_t* recorded;
+    size_t count;
+    size_t capacity;
+};
+
+static struct Timings timings[TRACE_EVENT_TYPE_COUNT];
+
+struct SlowEvent {
+    size_t index;
+    const struct TraceEvent* event;
+    uint64_t replayed;
+};
+
+static struct SlowEvent slowestEvents[SLOWEST_EVENT_COUNT];
+static size_t slowestEventCount = 0;
+
+static void addTiming(size_t const index, const struct TraceEvent* const event, uint64_t const replayed) {
+    struct Timings* const t = &timings[event->type];
+    if (t->count == t->capacity) {
+        t->capacity = t->capacity == 0 ? 256 : t->capacity * 2;
+        t->replayed = realloc(t->replayed, t->capacity * sizeof(uint64_t));
+        t->recorded = realloc(t->recorded, t->capacity * sizeof(uint64_t));
+    }
+    t->replayed[t->count] = replayed;
+    t->recorded[t->count] = event->duration;
+    t->count++;
+
+    // keep the slowest events sorted, slowest first
+    size_t i = slowestEventCount < SLOWEST_EVENT_COUNT ? slowestEventCount++ : SLOWEST_EVENT_COUNT;
+    while (i > 0 && slowestEvents[i - 1].replayed < replayed) {
+        if (i < SLOWEST_EVENT_COUNT) {
+            slowestEvents[i] = slowestEvents[i - 1];
+        }
+        i--;
+    }
+    if (i < SLOWEST_EVENT_COUNT) {
+        slowestEvents[i] = (struct SlowEvent){index, event, replayed};
+    }
+}
+
+static int compareTimes(const void* a, const void* b) {
+    uint64_t const ta = *(const uint64_t*)a;
+    uint64_t const tb = *(const uint64_t*)b;
+    return (ta > tb) - (ta < tb);
+}
+
+static uint64_t getPercentile(const uint64_t* const sorted, size_t const count, unsigned const percentile) {
+    return sorted[(count - 1) * percentile / 100];
+}
+
+static void reportTimings() {
+    printf("event             count  replay p50  replay p99  replay max  recorded p50  recorded p99  recorded max\n");
+    for (size_t type = 0; type < TRACE_EVENT_TYPE_COUNT; type++) {
+        struct Timings* const t = &timings[type];
+        if (t->count == 0) {
+            continue;
+        }
+        qsort(t->replayed, t->count, sizeof(uint64_t), &compareTimes);
+        qsort(t->recorded, t->count, sizeof(uint64_t), &compareTimes);
+        printf("%-15s %7zu %11lu %11lu %11lu %13lu %13lu %13lu\n", eventTypeNames[type], t->count,
+               (unsigned long)getPercentile(t->replayed, t->count, 50),
+               (unsigned long)getPercentile(t->replayed, t->count, 99),
+               (unsigned long)t->replayed[t->count - 1],
+               (unsigned long)getPercentile(t->recorded, t->count, 50),
+               (unsigned long)getPercentile(t->recorded, t->count, 99),
+               (unsigned long)t->recorded[t->count - 1]);
+        free(t->replayed);
+        free(t->recorded);
+    }
+
+    printf("\nslowest events (ns):\n");
+    for (size_t i = 0; i < slowestEventCount; i++) {
+        const struct SlowEvent* const slow = &slowestEvents[i];
+        printf("#%-8zu at %10.3f s  %-15s replayed %9lu  recorded %9lu\n", slow->index,
+               slow->event->time / 1e9, eventTypeNames[slow->event->type],
+               (unsigned long)slow->replayed, (unsigned long)slow->event->duration);
+    }
+}
+
+// replay
+
+static double scrollMult;
+static double prevPointerX = 0;
+static double prevPointerY = 0;
+
+static bool isGridDragState(uint32_t const mouseState) {
+    return mouseState == TRACE_MOUSE_MOVING_GRIDDED || mouseState == TRACE_MOUSE_RESIZING_WINDOW ||
+           mouseState == TRACE_MOUSE_RESIZING_ROW;
+}
+
+// the recorded mouse state tells which drag the button started or ended
+static void replayButton(const struct TraceEvent* const event) {
+    uint32_t const before = event->button.mouseStateBefore;
+    uint32_t const after = event->button.mouseStateAfter;
+    if (isGridDragState(before) && !isGridDragState(after)) {
+        endGridDrag();
+    } else if (before == TRACE_MOUSE_NORMAL && isGridDragState(after)) {
+        wlc_handle const view = getMapped(&viewMap, event->view);
+        if (event->view != 0 && getWindow(view) == NULL) {
+            return;  // not a view the replay knows about
+        }
+        if (after == TRACE_MOUSE_MOVING_GRIDDED) {
+            beginGridMove(view);
+        } else {
+            beginGridResize(view);
+        }
+    }
+}
+
+static void replayMotion(const struct TraceEvent* const event) {
+    wlc_handle const output = getMapped(&outputMap, event->output);
+    double const x = event->motion.x;
+    double const y = event->motion.y;
+    if (output != 0 && (event->motion.mouseState == TRACE_MOUSE_NORMAL || isGridDragState(event->motion.mouseState))) {
+        headlessFocusOutput(output);
+        headlessSetPointer(x, y);
+        wlc_handle const view = event->view == 0 ? 0 : getMapped(&viewMap, event->view);
+        gridPointerMotion(view, x - prevPointerX, y - prevPointerY);
+    }
+    prevPointerX = x;
+    prevPointerY = y;
+}
+
+static void replayCommand(const struct TraceEvent* const event) {
+    wlc_handle const output = getMapped(&outputMap, event->output);
+    wlc_handle const view = getMapped(&viewMap, event->view);
+    enum GridCommand const command = event->command.command;
+    if (output == 0 || command >= GRID_COMMAND_COUNT) {
+        return;
+    }
+    bool const needsWindow = command != GRID_COMMAND_UNDO && command != GRID_COMMAND_REDO &&
+                             command != GRID_COMMAND_FOCUS_ROW && command != GRID_COMMAND_FOCUS_ROW_RELATIVE;
+    if (needsWindow && getWindow(view) == NULL) {
+        return;
+    }
+    headlessFocusOutput(output);
+    runGridCommand(command, view, event->command.count);
+}
+
+static void replayEvent(const struct TraceEvent* const event) {
+    switch (event->type) {
+        case TRACE_OUTPUT_CREATED: {
+            struct GridSize const size = {event->outputCreated.w, event->outputCreated.h};
+            setMapped(&outputMap, event->output, headlessCreateOutput(size));
+            break;
+        }
+        case TRACE_OUTPUT_DESTROYED: {
+            wlc_handle const output = getMapped(&outputMap, event->output);
+            if (output != 0) {
+                headlessDestroyOutput(output);
+                setMapped(&outputMap, event->output, 0);
+            }
+            break;
+        }
+        case TRACE_VIEW_CREATED: {
+            wlc_handle const output = getMapped(&outputMap, event->output);
+            if (output != 0) {
+                struct GridSize const size = {event->viewCreated.w, event->viewCreated.h};
+                wlc_handle const parent = getMapped(&viewMap, event->viewCreated.parent);
+                setMapped(&viewMap, event->view, headlessCreateView(output, size, parent, event->viewCreated.gridded));
+            }
+            break;
+        }
+        case TRACE_VIEW_DESTROYED: {
+            wlc_handle const view = getMapped(&viewMap, event->view);
+            if (view != 0) {
+                cancelGridDrag();  // like mouseHandleViewClosed
+                headlessDestroyView(view);
+                setMapped(&viewMap, event->view, 0);
+            }
+            break;
+        }
+        case TRACE_POINTER_BUTTON: {
+            replayButton(event);
+            break;
+        }
+        case TRACE_POINTER_MOTION: {
+            replayMotion(event);
+            break;
+        }
+        case TRACE_POINTER_SCROLL: {
+            wlc_handle const output = getMapped(&outputMap, event->output);
+            if (output != 0 && event->flags & TRACE_HANDLED) {
+                scrollGrid(getGrid(output), event->scroll.amount[0] * scrollMult);
+            }
+            break;
+        }
+        case TRACE_FRAME: {
+            wlc_handle const output = getMapped(&outputMap, event->output);
+            if (output != 0) {
+                headlessRenderOutput(output);
+            }
+            break;
+        }
+        case TRACE_COMMAND: {
+            replayCommand(event);
+            break;
+        }
+        case TRACE_KEY:
+        default: break;
+    }
+}
+
+static struct TraceEvent* readTrace(const char* const path, size_t* const eventCount) {
+    FILE* const file = fopen(path, "rb");
+    if (file == NULL) {
+        fprintf(stderr, "Cannot open %s\n", path);
+        return NULL;
+    }
+    struct TraceHeader header;
+    if (fread(&header, sizeof(header), 1, file) != 1 ||
+        memcmp(header.magic, TRACE_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != TRACE_VERSION ||
+        header.eventSize != sizeof(struct TraceEvent)) {
+        fprintf(stderr, "%s is not a trace of this version\n", path);
+        fclose(file);
+        return NULL;
+    }
+    grid_windowSpacing = header.gridWindowSpacing;
+    grid_horizontal = header.gridHorizontal;
+    grid_minimizeEmptySpace = header.gridMinimizeEmptySpace;
+    scrollMult = header.behaviorScrollMult;
+
+    size_t capacity = 4096;
+    struct TraceEvent* events = malloc(capacity * sizeof(struct TraceEvent));
+    size_t count = 0;
+    while (true) {
+        if (count == capacity) {
+            capacity *= 2;
+            events = realloc(events, capacity * sizeof(struct TraceEvent));
+        }
+        size_t const read = fread(events + count, sizeof(struct TraceEvent), capacity - count, file);
+        count += read;
+        if (read == 0) {
+            break;
+        }
+    }
+    fclose(file);
+    *eventCount = count;
+    return events;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc != 2) {
+        fprintf(stderr, "Usage: %s TRACE\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    size_t eventCount;
+    struct TraceEvent* const events = readTrace(argv[1], &eventCount);
+    if (events == NULL) {
+        return EXIT_FAILURE;
+    }
+
+    headless_init();
+    grid_init(&headlessBackend);
+    for (size_t i = 0; i < eventCount; i++) {
+        const struct TraceEvent* const event = &events[i];
+        if (event->type >= TRACE_EVENT_TYPE_COUNT) {
+            fprintf(stderr, "Unknown event type %u at event %zu\n", event->type, i);
+            break;
+        }
+        uint64_t const start = now();
+        replayEvent(event);
+        addTiming(i, event, now() - start);
+    }
+    reportTimings();
+
+    headless_free();
+    grid_free();
+    free(events);
+    free(outputMap.handles);
+    free(viewMap.handles);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,174 @@
+#include "headlessbackend.h"
+#include "rowindex.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+// Checks that the drop shadow shows what a drop does: simulateMoveViewToEdge keeps its own copy of
+// moveViewToEdge's arrangement, so every case here simulates a drop, makes it and compares the shadow with the
+// geometry the flush applied to the views on screen.
+
+#define OUTPUT_WIDTH 1920
+#define OUTPUT_HEIGHT 1080
+#define VIEW_WIDTH 800
+#define VIEW_HEIGHT 600
+#define WINDOWS_PER_ROW 3
+#define WINDOW_COUNT 60
+#define RANDOM_DROP_COUNT 2000
+
+static struct ShadowLayout shadow = EMPTY_SHADOW_LAYOUT;
+static wlc_handle output;
+static wlc_handle views[WINDOW_COUNT];
+
+static uint32_t randomState = 2463534242;
+
+static uint32_t nextRandom() {
+    // xorshift
+    randomState ^= randomState << 13;
+    randomState ^= randomState >> 17;
+    randomState ^= randomState << 5;
+    return randomState;
+}
+
+static const char* getEdgeTypeName(enum EdgeType const type) {
+    return type == EDGE_ROW ? "row" : "window";
+}
+
+// the views on screen after the flush must be exactly the ones in the shadow, at the shadow's geometry
+static bool compareWithShadow(const char* const name) {
+    size_t shownCount = 0;
+    for (const struct Row* row = getGrid(output)->firstRow; row != NULL; row = row->next) {
+        for (const struct Window* window = row->firstWindow; window != NULL; window = window->next) {
+            shownCount += window->appliedMask != 0;
+        }
+    }
+    if (shownCount != shadow.windowCount) {
+        fprintf(stderr, "%s: %zu windows on screen, %zu in the shadow\n", name, shownCount, shadow.windowCount);
+        return false;
+    }
+    for (size_t i = 0; i < shadow.windowCount; i++) {
+        const struct ShadowWindow* const ghost = &shadow.windows[i];
+        const struct Window* const window = getWindow(ghost->view);
+        const struct GridGeometry* const applied = &window->appliedGeometry;
+        if (window->appliedMask == 0 || applied->origin.x != ghost->geometry.origin.x ||
+            applied->origin.y != ghost->geometry.origin.y || applied->size.w != ghost->geometry.size.w ||
+            applied->size.h != ghost->geometry.size.h) {
+            fprintf(stderr, "%s: view %lu is at %d,%d %ux%u, the shadow has it at %d,%d %ux%u\n", name,
+                    (unsigned long)ghost->view, applied->origin.x, applied->origin.y, applied->size.w, applied->size.h,
+                    ghost->geometry.origin.x, ghost->geometry.origin.y, ghost->geometry.size.w, ghost->geometry.size.h);
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool checkDrop(const char* const name, wlc_handle const view, struct Edge edge) {
+    if (doesEdgeBelongToView(&edge, view)) {
+        fprintf(stderr, "%s: the edge belongs to the view\n", name);
+        return false;
+    }
+    headlessRender();
+    simulateMoveViewToEdge(view, &edge, &shadow);
+    moveViewToEdge(view, &edge);
+    headlessRender();
+    return compareWithShadow(name);
+}
+
+static void fillGrid() {
+    struct Grid* const grid = getGrid(output);
+    for (size_t i = 0; i < WINDOW_COUNT; i++) {
+        views[i] = headlessCreateView(output, (struct GridSize){VIEW_WIDTH, VIEW_HEIGHT}, 0, true);
+        if (i % WINDOWS_PER_ROW != 0) {
+            struct Row* const prevRow = grid->lastRow->prev;
+            struct Edge edge = {EDGE_WINDOW, prevRow, prevRow->lastWindow};
+            moveViewToEdge(views[i], &edge);
+        }
+    }
+}
+
+static void scrollToEnd(struct Grid* const grid) {
+    scrollGrid(grid, (double)rowIndexGetLength(grid));
+}
+
+// the drops the simulation handles separately
+static bool checkSpecialDrops() {
+    struct Grid* const grid = getGrid(output);
+    bool ok = true;
+
+    ok = checkDrop("row before the first row", grid->firstRow->next->firstWindow->view,
+                   (struct Edge){EDGE_ROW, NULL, NULL}) && ok;
+
+    ok = checkDrop("row after the last row", grid->firstRow->next->lastWindow->view,
+                   (struct Edge){EDGE_ROW, grid->lastRow, NULL}) && ok;
+
+    struct Row* const targetRow = grid->firstRow->next->next;
+    ok = checkDrop("first window of a row", grid->firstRow->next->firstWindow->view,
+                   (struct Edge){EDGE_WINDOW, targetRow, NULL}) && ok;
+
+    // the first row holds the view dropped before it alone, moving that view removes the row
+    ok = checkDrop("emptying the source row", grid->firstRow->firstWindow->view,
+                   (struct Edge){EDGE_WINDOW, grid->firstRow->next->next, grid->firstRow->next->next->lastWindow}) && ok;
+
+    scrollToEnd(grid);
+    ok = checkDrop("scrolled to the end", grid->lastRow->prev->firstWindow->view,
+                   (struct Edge){EDGE_ROW, grid->firstRow, NULL}) && ok;
+
+    // the last row holds the view dropped after it alone, so the grid gets shorter and the scroll is clamped
+    scrollToEnd(grid);
+    ok = checkDrop("emptying the last row while scrolled to the end", grid->lastRow->firstWindow->view,
+                   (struct Edge){EDGE_WINDOW, grid->firstRow, grid->firstRow->lastWindow}) && ok;
+    return ok;
+}
+
+// any view to any edge that doesn't belong to it, at any scroll
+static bool checkRandomDrops() {
+    struct Grid* const grid = getGrid(output);
+    for (size_t i = 0; i < RANDOM_DROP_COUNT; i++) {
+        if (nextRandom() % 4 == 0) {
+            scrollGrid(grid, (double)(nextRandom() % (uint32_t)rowIndexGetLength(grid)) - grid->scroll);
+        }
+        wlc_handle const view = views[nextRandom() % WINDOW_COUNT];
+        struct Row* row = rowIndexGetAt(grid, nextRandom() % (rowIndexGetCount(grid) + 1));  // NULL past the end
+        struct Edge edge;
+        if (row == NULL || nextRandom() % 2 == 0) {
+            edge = (struct Edge){EDGE_ROW, row == NULL ? grid->lastRow : row->prev, NULL};
+        } else {
+            struct Window* prev = NULL;
+            for (uint32_t w = nextRandom() % (row->windowCount + 1); w > 0; w--) {
+                prev = prev == NULL ? row->firstWindow : prev->next;
+            }
+            edge = (struct Edge){EDGE_WINDOW, row, prev};
+        }
+        if (doesEdgeBelongToView(&edge, view)) {
+            continue;
+        }
+        char name[64];
+        snprintf(name, sizeof(name), "random drop %zu to a %s edge", i, getEdgeTypeName(edge.type));
+        if (!checkDrop(name, view, edge)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(void) {
+    bool ok = true;
+    for (int horizontal = 1; horizontal >= 0; horizontal--) {
+        grid_horizontal = horizontal;
+        headless_init();
+        grid_init(&headlessBackend);
+        output = headlessCreateOutput((struct GridSize){OUTPUT_WIDTH, OUTPUT_HEIGHT});
+        fillGrid();
+
+        bool const specialOk = checkSpecialDrops();
+        bool const randomOk = checkRandomDrops();
+        printf("%-10s special drops %s, random drops %s\n", horizontal ? "horizontal" : "vertical",
+               specialOk ? "ok" : "FAILED", randomOk ? "ok" : "FAILED");
+        ok = ok && specialOk && randomOk;
+
+        freeShadowLayout(&shadow);
+        headless_free();
+        grid_free();
+    }
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
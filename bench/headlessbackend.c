@@ -0,0 +1,238 @@
+#include "headlessbackend.h"
+
+#include <assert.h>
+#include <stdlib.h>
+
+// handles are indices, 0 is never used (wlc uses it for "no view")
+static struct HeadlessView* views = NULL;
+static size_t viewCount = 1;
+static size_t viewCapacity = 0;
+static struct HeadlessOutput* outputs = NULL;
+static size_t outputCount = 1;
+static size_t outputCapacity = 0;
+
+static wlc_handle focusedOutput = 0;
+static wlc_handle focusedView = 0;
+static double pointerX = 0.0;
+static double pointerY = 0.0;
+
+struct HeadlessStats headlessStats = {0, 0, 0, 0};
+
+void headless_init() {
+    viewCapacity = 64;
+    views = calloc(viewCapacity, sizeof(struct HeadlessView));
+    outputCapacity = 4;
+    outputs = calloc(outputCapacity, sizeof(struct HeadlessOutput));
+}
+
+void headless_free() {
+    for (wlc_handle output = 1; output < outputCount; output++) {
+        if (outputs[output].exists) {
+            headlessDestroyOutput(output);
+        }
+    }
+    free(views);
+    free(outputs);
+    views = NULL;
+    outputs = NULL;
+    viewCount = 1;
+    outputCount = 1;
+}
+
+struct HeadlessView* getHeadlessView(wlc_handle const view) {
+    if (view == 0 || view >= viewCount || !views[view].exists) {
+        return NULL;
+    }
+    return &views[view];
+}
+
+static struct HeadlessOutput* getHeadlessOutput(wlc_handle const output) {
+    assert (output > 0 && output < outputCount && outputs[output].exists);
+    return &outputs[output];
+}
+
+// outputs
+
+wlc_handle headlessCreateOutput(struct GridSize const size) {
+    if (outputCount == outputCapacity) {
+        outputCapacity *= 2;
+        outputs = realloc(outputs, outputCapacity * sizeof(struct HeadlessOutput));
+    }
+    wlc_handle const output = outputCount++;
+    outputs[output] = (struct HeadlessOutput){true, NULL, size, false};
+    outputs[output].grid = createGrid(output);
+    if (focusedOutput == 0) {
+        focusedOutput = output;
+    }
+    return output;
+}
+
+void headlessDestroyOutput(wlc_handle const output) {
+    struct HeadlessOutput* const outputRecord = getHeadlessOutput(output);
+    struct Grid* targetGrid = NULL;
+    for (wlc_handle other = 1; other < outputCount; other++) {
+        if (other != output && outputs[other].exists) {
+            targetGrid = outputs[other].grid;
+            break;
+        }
+    }
+    evacuateGrid(outputRecord->grid, targetGrid);
+    destroyGrid(outputRecord->grid);
+    outputRecord->exists = false;
+    if (focusedOutput == output) {
+        focusedOutput = targetGrid == NULL ? 0 : targetGrid->output;
+    }
+}
+
+void headlessFocusOutput(wlc_handle const output) {
+    focusedOutput = output;
+}
+
+void headlessRenderOutput(wlc_handle const output) {
+    struct HeadlessOutput* const outputRecord = getHeadlessOutput(output);
+    if (outputRecord->renderScheduled) {
+        outputRecord->renderScheduled = false;
+        flushGridLayout(outputRecord->grid);
+        headlessStats.framesRendered++;
+    }
+}
+
+void headlessRender() {
+    for (wlc_handle output = 1; output < outputCount; output++) {
+        if (outputs[output].exists) {
+            headlessRenderOutput(output);
+        }
+    }
+}
+
+// views
+
+wlc_handle headlessCreateView(wlc_handle const output, struct GridSize const size, wlc_handle const parent, bool const gridded) {
+    if (viewCount == viewCapacity) {
+        viewCapacity *= 2;
+        views = realloc(views, viewCapacity * sizeof(struct HeadlessView));
+    }
+    wlc_handle const view = viewCount++;
+    views[view] = (struct HeadlessView){true, NULL, output, parent, {{0, 0}, size}, 1};
+    if (gridded) {
+        views[view].window = createWindow(view);
+    }
+    focusedView = view;
+    return view;
+}
+
+void headlessDestroyView(wlc_handle const view) {
+    if (getHeadlessView(view) == NULL) {
+        return;  // already closed by the grid
+    }
+    destroyWindow(view);
+    views[view].exists = false;
+    if (focusedView == view) {
+        focusedView = 0;
+    }
+}
+
+wlc_handle headlessGetFocusedView() {
+    return focusedView;
+}
+
+void headlessSetPointer(double const x, double const y) {
+    pointerX = x;
+    pointerY = y;
+}
+
+// backend
+
+static struct Grid* getOutputGrid(wlc_handle const output) {
+    return getHeadlessOutput(output)->grid;
+}
+
+static struct Window* getViewWindow(wlc_handle const view) {
+    const struct HeadlessView* const record = getHeadlessView(view);
+    return record == NULL ? NULL : record->window;
+}
+
+static void forgetWindow(wlc_handle const view) {
+    views[view].window = NULL;
+}
+
+static wlc_handle getViewParent(wlc_handle const view) {
+    const struct HeadlessView* const record = getHeadlessView(view);
+    return record == NULL ? 0 : record->parent;
+}
+
+static wlc_handle getViewOutput(wlc_handle const view) {
+    return views[view].output;
+}
+
+static struct GridGeometry getViewGeometry(wlc_handle const view) {
+    return views[view].geometry;
+}
+
+static void setViewGeometry(wlc_handle const view, const struct GridGeometry* const geometry) {
+    views[view].geometry = *geometry;
+    headlessStats.geometriesSet++;
+}
+
+static void setViewMask(wlc_handle const view, uint32_t const mask) {
+    views[view].mask = mask;
+    headlessStats.masksSet++;
+}
+
+static void setViewOutput(wlc_handle const view, wlc_handle const output) {
+    views[view].output = output;
+}
+
+static void focusView(wlc_handle const view) {
+    focusedView = view;
+}
+
+static void closeView(wlc_handle const view) {
+    // a real client would be destroyed a bit later, here it's gone at once
+    views[view].exists = false;
+    if (focusedView == view) {
+        focusedView = 0;
+    }
+}
+
+static struct GridSize getOutputSize(wlc_handle const output) {
+    return getHeadlessOutput(output)->size;
+}
+
+static wlc_handle getFocusedOutput() {
+    return focusedOutput;
+}
+
+static void scheduleRender(wlc_handle const output) {
+    getHeadlessOutput(output)->renderScheduled = true;
+    headlessStats.rendersScheduled++;
+}
+
+static void getPointerPosition(double* const x, double* const y) {
+    *x = pointerX;
+    *y = pointerY;
+}
+
+static void edgesInvalidated(bool const windowsFreed) {
+    (void)windowsFreed;  // no pointer state kept
+}
+
+const struct GridBackend headlessBackend = {
+    .getGrid                = &getOutputGrid,
+    .getWindow              = &getViewWindow,
+    .forgetWindow           = &forgetWindow,
+    .getViewParent          = &getViewParent,
+    .getViewOutput          = &getViewOutput,
+    .getViewGeometry        = &getViewGeometry,
+    .getViewVisibleGeometry = &getViewGeometry,  // headless views are drawn at their geometry right away
+    .setViewGeometry        = &setViewGeometry,
+    .setViewMask            = &setViewMask,
+    .setViewOutput          = &setViewOutput,
+    .focusView              = &focusView,
+    .closeView              = &closeView,
+    .getOutputSize          = &getOutputSize,
+    .getFocusedOutput       = &getFocusedOutput,
+    .scheduleRender         = &scheduleRender,
+    .getPointerPosition     = &getPointerPosition,
+    .edgesInvalidated       = &edgesInvalidated,
+};
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "grid.h"
+
+// A GridBackend without a compositor. Views and outputs only exist as records in memory,
+// geometry sent to them is stored, and rendering is simulated by headlessRender.
+
+struct HeadlessView {
+    bool exists;
+    struct Window* window;
+    wlc_handle output;
+    wlc_handle parent;
+    struct GridGeometry geometry;
+    uint32_t mask;
+};
+
+struct HeadlessOutput {
+    bool exists;
+    struct Grid* grid;
+    struct GridSize size;
+    bool renderScheduled;
+};
+
+extern const struct GridBackend headlessBackend;
+
+extern struct HeadlessStats {
+    uint64_t geometriesSet;
+    uint64_t masksSet;
+    uint64_t rendersScheduled;
+    uint64_t framesRendered;
+} headlessStats;
+
+void headless_init();
+void headless_free();  // destroys remaining outputs and forgets all views
+
+wlc_handle headlessCreateOutput(struct GridSize size);
+void headlessDestroyOutput(wlc_handle output);  // evacuates to another output like the metamanager does
+wlc_handle headlessCreateView(wlc_handle output, struct GridSize size, wlc_handle parent, bool gridded);
+void headlessDestroyView(wlc_handle view);
+struct HeadlessView* getHeadlessView(wlc_handle view);  // NULL if view doesn't exist
+
+void headlessFocusOutput(wlc_handle output);
+wlc_handle headlessGetFocusedView();
+void headlessSetPointer(double x, double y);
+void headlessRenderOutput(wlc_handle output);  // flushes the layout if a render was scheduled, like output_render_pre
+void headlessRender();  // renders all outputs
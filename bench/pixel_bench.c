@@ -0,0 +1,96 @@
+#include "pixels.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Times every pixel kernel the CPU supports on output-sized buffers and reports throughput in GB/s of pixels
+// written, the best of SAMPLE_COUNT runs. Blend results are checked against the scalar kernel.
+// Numbers only mean something in an optimized build, e.g. with -DCMAKE_BUILD_TYPE=Release.
+
+#define SAMPLE_COUNT 20
+#define BLEND_COLOR 0xA0000000
+
+struct Resolution {
+    const char* name;
+    uint32_t w;
+    uint32_t h;
+};
+
+static const struct Resolution resolutions[] = {
+    {"1080p", 1920, 1080},
+    {"1440p", 2560, 1440},
+    {"4K",    3840, 2160},
+};
+
+static uint64_t now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static uint32_t nextRandom() {
+    // xorshift, seeded the same every run so runs are comparable
+    static uint32_t state = 2463534242;
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+typedef void (*PixelKernel)(uint32_t* dst, size_t count, uint32_t color);
+
+static double getThroughput(PixelKernel const kernel, uint32_t* const pixels, size_t const count, uint32_t const color) {
+    uint64_t best = UINT64_MAX;
+    for (size_t i = 0; i < SAMPLE_COUNT; i++) {
+        uint64_t const start = now();
+        kernel(pixels, count, color);
+        uint64_t const duration = now() - start;
+        if (duration < best) {
+            best = duration;
+        }
+    }
+    return (double)(count * sizeof(uint32_t)) / best;  // bytes per ns is GB/s
+}
+
+int main(void) {
+    pixels_init();
+    const struct PixelKernels* const* kernels;
+    size_t const kernelCount = getSupportedPixelKernels(&kernels);
+
+    size_t const maxCount = (size_t)3840 * 2160;
+    uint32_t* const pixels = malloc(maxCount * sizeof(uint32_t));
+    uint32_t* const source = malloc(maxCount * sizeof(uint32_t));
+    uint32_t* const expected = malloc(maxCount * sizeof(uint32_t));
+    for (size_t i = 0; i < maxCount; i++) {
+        source[i] = nextRandom();
+    }
+
+    bool mismatch = false;
+    printf("size    kernel   fill GB/s  blend GB/s\n");
+    for (size_t r = 0; r < sizeof(resolutions) / sizeof(resolutions[0]); r++) {
+        size_t const count = (size_t)resolutions[r].w * resolutions[r].h;
+        memcpy(expected, source, count * sizeof(uint32_t));
+        kernels[0]->blend(expected, count, BLEND_COLOR);
+
+        for (size_t k = 0; k < kernelCount; k++) {
+            memcpy(pixels, source, count * sizeof(uint32_t));
+            kernels[k]->blend(pixels, count, BLEND_COLOR);
+            if (memcmp(pixels, expected, count * sizeof(uint32_t)) != 0) {
+                fprintf(stderr, "%s blend differs from scalar at %s\n", kernels[k]->name, resolutions[r].name);
+                mismatch = true;
+            }
+
+            double const fill = getThroughput(kernels[k]->fill, pixels, count, 0xff804000);
+            double const blend = getThroughput(kernels[k]->blend, pixels, count, BLEND_COLOR);
+            printf("%-7s %-8s %9.2f %11.2f\n", resolutions[r].name, kernels[k]->name, fill, blend);
+        }
+    }
+
+    free(pixels);
+    free(source);
+    free(expected);
+    return mismatch ? EXIT_FAILURE : EXIT_SUCCESS;
+}
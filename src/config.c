@@ -9,15 +9,14 @@
 
 // Appearance
 bool appearance_dimInactive;
+uint32_t appearance_wallpaperColor;
+char* appearance_wallpaperImage;
 
 // Behavior
 double behavior_scrollMult;
 
 // Grid
-bool grid_horizontal;
-bool grid_minimizeEmptySpace;
 bool grid_floatingDialogs;
-uint32_t grid_windowSpacing;
 
 // Keybindings
 uint32_t MOD_WM0;
@@ -34,6 +33,8 @@ struct Keystroke keystroke_moveWindowLeft;
 struct Keystroke keystroke_moveWindowRight;
 struct Keystroke keystroke_moveRowBack;
 struct Keystroke keystroke_moveRowForward;
+struct Keystroke keystroke_undo;
+struct Keystroke keystroke_redo;
 
 // Mousebindings
 struct Keystroke mousestroke_move;
@@ -46,6 +47,8 @@ size_t applicationShortcutCount;
 static void initDefaults() {
     // Appearance
     appearance_dimInactive = false;
+    appearance_wallpaperColor = 0xFF804000;
+    appearance_wallpaperImage = NULL;
 
     // Behavior
     behavior_scrollMult = 5.0;
@@ -82,6 +85,8 @@ static void setMainMod(bool const useAlt) {
     keystroke_moveWindowRight    = (struct Keystroke){MOD_WM1, XKB_KEY_Right};
     keystroke_moveRowBack        = (struct Keystroke){MOD_WM2, XKB_KEY_Up};
     keystroke_moveRowForward     = (struct Keystroke){MOD_WM2, XKB_KEY_Down};
+    keystroke_undo               = (struct Keystroke){MOD_WM0, XKB_KEY_z};
+    keystroke_redo               = (struct Keystroke){MOD_WM1, XKB_KEY_z};
 
     // Mousebindings (not configurable)
     mousestroke_move   = (struct Keystroke){MOD_WM0, BTN_LEFT};
@@ -152,6 +157,40 @@ static void readDouble(double* pref, const char* key) {
     }
 }
 
+// an empty string reads as NULL
+static void readString(char** pref, const char* key) {
+    char* value = g_key_file_get_string(configFile, group, key, &error);
+    if (error != NULL) {
+        g_key_file_set_string(configFile, group, key, *pref == NULL ? "" : *pref);
+        changesMade = true;
+        error = NULL;
+    } else if (value[0] == '\0') {
+        g_free(value);
+        *pref = NULL;
+    } else {
+        *pref = value;
+    }
+}
+
+// written as #RRGGBB, kept as an opaque WLC_RGBA8888 pixel
+static void readColor(uint32_t* pref, const char* key) {
+    char* value = g_key_file_get_string(configFile, group, key, &error);
+    unsigned r, g, b;
+    if (error != NULL) {
+        char colorString[8];
+        snprintf(colorString, sizeof(colorString), "#%02x%02x%02x",
+                 *pref & 0xFF, (*pref >> 8) & 0xFF, (*pref >> 16) & 0xFF);
+        g_key_file_set_string(configFile, group, key, colorString);
+        changesMade = true;
+        error = NULL;
+    } else if (sscanf(value, "#%2x%2x%2x", &r, &g, &b) == 3) {
+        *pref = 0xFF000000 | b << 16 | g << 8 | r;
+    } else {
+        fprintf(stderr, "Invalid color %s for %s, expected #RRGGBB\n", value, key);
+    }
+    g_free(value);
+}
+
 void readConfig() {
     initDefaults();
     configFile = g_key_file_new();
@@ -162,7 +201,9 @@ void readConfig() {
     }
 
     group = "Appearance";
-    readBoolean(&appearance_dimInactive, "dimInactive");
+    readBoolean(&appearance_dimInactive   , "dimInactive");
+    readColor  (&appearance_wallpaperColor, "wallpaperColor");
+    readString (&appearance_wallpaperImage, "wallpaperImage");
 
     group = "Behavior";
     readDouble(&behavior_scrollMult, "scrollSpeed");
@@ -190,6 +231,8 @@ void readConfig() {
     readKeybinding(&keystroke_moveWindowRight , "moveWindowRight");
     readKeybinding(&keystroke_moveRowBack     , "moveRowBack");
     readKeybinding(&keystroke_moveRowForward  , "moveRowForward");
+    readKeybinding(&keystroke_undo            , "undo");
+    readKeybinding(&keystroke_redo            , "redo");
 
     group = "Application Shortcuts";
     if (g_key_file_has_group(configFile, group)) {
@@ -2,6 +2,7 @@
 
 #include <wlc/wlc.h>
 
+#include "grid.h"
 #include "keystroke.h"
 
 #define MOD_WM1 (MOD_WM0 | WLC_BIT_MOD_SHIFT)
@@ -15,15 +16,14 @@ struct ApplicationShortcut {
 
 // Appearance
 extern bool appearance_dimInactive;
+extern uint32_t appearance_wallpaperColor;
+extern char* appearance_wallpaperImage;  // NULL for a plain color
 
 // Behavior
 extern double behavior_scrollMult;
 
-// Grid
-extern bool grid_horizontal;
-extern bool grid_minimizeEmptySpace;
+// Grid (the rest is declared in grid.h)
 extern bool grid_floatingDialogs;
-extern uint32_t grid_windowSpacing;
 
 // Keybindings
 extern uint32_t MOD_WM0;
@@ -40,6 +40,8 @@ extern struct Keystroke keystroke_moveWindowLeft;
 extern struct Keystroke keystroke_moveWindowRight;
 extern struct Keystroke keystroke_moveRowBack;
 extern struct Keystroke keystroke_moveRowForward;
+extern struct Keystroke keystroke_undo;
+extern struct Keystroke keystroke_redo;
 
 // Mousebindings
 extern struct Keystroke mousestroke_move;
@@ -3,7 +3,11 @@
 #include "keyboard.h"
 #include "mouse.h"
 #include "painting.h"
+#include "pixels.h"
 #include "metamanager.h"
+#include "session.h"
+#include "trace.h"
+#include "wlcbackend.h"
 
 #include <stdlib.h>
 #include <stdio.h>
@@ -11,15 +15,21 @@
 #define STARTUP_SCRIPT_PATH "/.xprofile"
 
 static bool view_created(wlc_handle view) {
+    uint64_t const start = traceStart();
     wlc_view_set_mask(view, wlc_output_get_mask(wlc_view_get_output(view)));
     onViewCreated(view);
     wlc_view_focus(view);
+    damageOverlays();
+    traceViewCreated(view, start);
     return true;
 }
 
 static void view_destroyed(wlc_handle view) {
+    uint64_t const start = traceStart();
     mouseHandleViewClosed(view);
     onViewDestroyed(view);
+    damageOverlays();
+    traceViewDestroyed(view, start);
 }
 
 static void view_request_move(wlc_handle view, const struct wlc_point* origin) {
@@ -33,11 +43,13 @@ static void view_request_resize(wlc_handle view, uint32_t edges, const struct wl
 static void view_request_geometry(wlc_handle view, const struct wlc_geometry* g) {
     if (!viewResized(view)) {
         wlc_view_set_geometry(view, 0, g);
+        damageOverlays();
     }
 }
 
 static void view_focus(wlc_handle view, bool focus) {
     wlc_view_set_state(view, WLC_BIT_ACTIVATED, focus);
+    damageOverlays();  // inactive views are dimmed
     if (focus) {
         if (getWindow(view) == NULL) {
             wlc_view_bring_to_front(view);
@@ -47,11 +59,16 @@ static void view_focus(wlc_handle view, bool focus) {
 }
 
 static bool output_created(wlc_handle const output) {
-    return onOutputCreated(output) != NULL;
+    uint64_t const start = traceStart();
+    bool const created = onOutputCreated(output) != NULL;
+    traceOutputCreated(output, start);
+    return created;
 }
 
 static void output_destroyed(wlc_handle const output) {
+    uint64_t const start = traceStart();
     onOutputDestroyed(output);
+    traceOutputDestroyed(output, start);
 }
 
 // TODO: resolution changed
@@ -64,29 +81,37 @@ static void runStartupScript() {
 
 int main(int argc, char *argv[]) {
     readConfig();
+    pixels_init();
     meta_init();
-    grid_init();
-    
+    grid_init(&wlcBackend);
+    trace_init();
+
     wlc_set_view_created_cb         (&view_created);
     wlc_set_view_destroyed_cb       (&view_destroyed);
     wlc_set_view_focus_cb           (&view_focus);
-    wlc_set_keyboard_key_cb         (&keyboard_key);
-    wlc_set_pointer_button_cb       (&pointer_button);
-    wlc_set_pointer_motion_cb_v2    (&pointer_motion);
-    wlc_set_pointer_scroll_cb       (&pointer_scroll);
+    wlc_set_keyboard_key_cb         (&traced_keyboard_key);
+    wlc_set_pointer_button_cb       (&traced_pointer_button);
+    wlc_set_pointer_motion_cb_v2    (&traced_pointer_motion);
+    wlc_set_pointer_scroll_cb       (&traced_pointer_scroll);
     wlc_set_view_request_move_cb    (&view_request_move);
     wlc_set_view_request_resize_cb  (&view_request_resize);
     wlc_set_view_request_geometry_cb(&view_request_geometry);
     wlc_set_output_created_cb       (&output_created);
     wlc_set_output_destroyed_cb     (&output_destroyed);
     wlc_set_compositor_ready_cb     (&runStartupScript);
-    wlc_set_output_render_pre_cb    (&output_render_pre);
+    wlc_set_output_render_pre_cb    (&traced_output_render_pre);
     wlc_set_output_render_post_cb   (&output_render_post);
 
     if (!wlc_init())
         return EXIT_FAILURE;
 
+    session_init();
     wlc_run();
+    printGeometryStats();
+    printPaintingStats();
+    trace_free();
+    session_free();
     meta_free();
+    grid_free();
     return EXIT_SUCCESS;
 }
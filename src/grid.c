@@ -1,43 +1,236 @@
 #include "grid.h"
-#include "config.h"
-#include "metamanager.h"
-#include "mouse.h"
+#include "history.h"
+#include "griddrag.h"
+#include "pool.h"
+#include "rowindex.h"
 
+#include <assert.h>
 #include <float.h>
+#include <inttypes.h>
 #include <math.h>
 #include <stdlib.h>
 #include <stdio.h>
-#include <wlc/wlc-render.h>
 
 #define ROW_EDGE_GRAB_SIZE (grid_windowSpacing / 2 + 24)
 
-static uint32_t GRIDDABLE_TYPES = 0;
+bool grid_horizontal = true;
+bool grid_minimizeEmptySpace = true;
+uint32_t grid_windowSpacing = 8;
 
-void grid_init() {
-    if (!grid_floatingDialogs) {
-        GRIDDABLE_TYPES |= WLC_BIT_MODAL;
+static const struct GridBackend* backend = NULL;
+
+struct GeometryStats geometryStats = {0, 0, 0, 0};
+
+// rows and windows are allocated from pools, so the ones created together are adjacent in memory
+static struct Pool rowPool;
+static struct Pool windowPool;
+
+// scratch space for distributing a row's length over its windows
+static uint32_t* rowWeights = NULL;
+static uint32_t* rowSizes = NULL;
+static size_t rowScratchCapacity = 0;
+
+// orientation
+
+// The layout and hit-test functions that depend on grid_horizontal are written once with the orientation as a
+// parameter, and compiled twice by DEFINE_ORIENTATION with the orientation as a constant. grid_init picks one of
+// the two tables, so the orientation isn't checked in the inner loops.
+
+typedef struct Window* (*WindowNeighborGetter)(const struct Window* window);
+
+struct Orientation {
+    uint32_t (*getLongSize)(struct GridSize size);  // size across the rows
+    uint32_t (*getLatSize)(struct GridSize size);   // size along a row
+    uint32_t (*getWindowPreferredSize)(const struct Window* window);
+    void (*setWindowPreferredSize)(struct Window* window, uint32_t size);
+    void (*setRowPreferredSize)(struct Row* row);   // sets the row's size as the preferred size of its windows
+    size_t (*gatherPreferredSizes)(const struct Row* row, uint64_t* sum);  // into rowWeights, returns the count
+    void (*applyRowGeometryAt)(const struct Row* row, int32_t screenOrigin, bool visible);
+    struct GridGeometry (*getWindowGeometry)(int32_t rowScreenOrigin, uint32_t rowSize, uint32_t windowOrigin, uint32_t windowSize);
+    void (*getPointerPositionWithScroll)(const struct Grid* grid, double* longPos, double* latPos);
+    WindowNeighborGetter getWindowAbove;
+    WindowNeighborGetter getWindowBelow;
+    WindowNeighborGetter getWindowLeft;
+    WindowNeighborGetter getWindowRight;
+};
+
+static const struct Orientation* orientation = NULL;
+
+static inline uint32_t getLongSizeOriented(struct GridSize const size, bool const horizontal) {
+    return horizontal ? size.w : size.h;
+}
+
+static inline uint32_t getLatSizeOriented(struct GridSize const size, bool const horizontal) {
+    return horizontal ? size.h : size.w;
+}
+
+static inline uint32_t getWindowPreferredSizeOriented(const struct Window* const window, bool const horizontal) {
+    return horizontal ? window->preferredHeight : window->preferredWidth;
+}
+
+static inline void setWindowPreferredSizeOriented(struct Window* const window, uint32_t const size, bool const horizontal) {
+    if (horizontal) {
+        window->preferredHeight = size;
+    } else {
+        window->preferredWidth = size;
+    }
+}
+
+static inline void setRowPreferredSizeOriented(struct Row* const row, bool const horizontal) {
+    for (struct Window* window = row->firstWindow; window != NULL; window = window->next) {
+        if (horizontal) {
+            window->preferredWidth = row->size;
+        } else {
+            window->preferredHeight = row->size;
+        }
+    }
+}
+
+static inline size_t gatherPreferredSizesOriented(const struct Row* const row, uint64_t* const sum, bool const horizontal) {
+    ensureRowScratchCapacity(row->windowCount);
+    size_t count = 0;
+    *sum = 0;
+    for (const struct Window* window = row->firstWindow; window != NULL; window = window->next) {
+        uint32_t const preferredSize = getWindowPreferredSizeOriented(window, horizontal);
+        rowWeights[count++] = preferredSize;
+        *sum += preferredSize;
+    }
+    return count;
+}
+
+static inline struct GridGeometry getWindowGeometryOriented(int32_t const rowScreenOrigin, uint32_t const rowSize,
+                                                             uint32_t const windowOrigin, uint32_t const windowSize,
+                                                             bool const horizontal) {
+    struct GridGeometry geometry;
+    if (horizontal) {
+        geometry.origin.x = rowScreenOrigin;
+        geometry.origin.y = windowOrigin;
+        geometry.size.w = rowSize;
+        geometry.size.h = windowSize;
+    } else {
+        geometry.origin.x = windowOrigin;
+        geometry.origin.y = rowScreenOrigin;
+        geometry.size.w = windowSize;
+        geometry.size.h = rowSize;
+    }
+    return geometry;
+}
+
+static inline void applyWindowGeometryOriented(struct Window* const window, int32_t const rowScreenOrigin, bool const visible, bool const horizontal) {
+    // hide offscreen views
+    setWindowMask(window, (uint32_t)visible);
+
+    if (visible) {
+        struct GridGeometry const geometry = getWindowGeometryOriented(rowScreenOrigin, window->parent->size,
+                                                                       window->origin, window->size, horizontal);
+        setWindowGeometry(window, &geometry);
+    }
+}
+
+static inline void applyRowGeometryAtOriented(const struct Row* const row, int32_t const screenOrigin, bool const visible, bool const horizontal) {
+    for (struct Window* window = row->firstWindow; window != NULL; window = window->next) {
+        applyWindowGeometryOriented(window, screenOrigin, visible, horizontal);
+    }
+}
+
+static inline void getPointerPositionWithScrollOriented(const struct Grid* const grid, double* const longPos, double* const latPos, bool const horizontal) {
+    double x, y;
+    backend->getPointerPosition(&x, &y);
+
+    if (horizontal) {
+        *longPos = x + grid->scroll;
+        *latPos = y;
+    } else {
+        *longPos = y + grid->scroll;
+        *latPos = x;
     }
 }
 
+#define DEFINE_ORIENTATION(name, horizontal)                                                                   \
+    static uint32_t getLongSize##name(struct GridSize size) {                                                  \
+        return getLongSizeOriented(size, horizontal);                                                          \
+    }                                                                                                          \
+    static uint32_t getLatSize##name(struct GridSize size) {                                                   \
+        return getLatSizeOriented(size, horizontal);                                                           \
+    }                                                                                                          \
+    static uint32_t getWindowPreferredSize##name(const struct Window* window) {                                \
+        return getWindowPreferredSizeOriented(window, horizontal);                                             \
+    }                                                                                                          \
+    static void setWindowPreferredSize##name(struct Window* window, uint32_t size) {                           \
+        setWindowPreferredSizeOriented(window, size, horizontal);                                              \
+    }                                                                                                          \
+    static void setRowPreferredSize##name(struct Row* row) {                                                   \
+        setRowPreferredSizeOriented(row, horizontal);                                                          \
+    }                                                                                                          \
+    static size_t gatherPreferredSizes##name(const struct Row* row, uint64_t* sum) {                           \
+        return gatherPreferredSizesOriented(row, sum, horizontal);                                             \
+    }                                                                                                          \
+    static void applyRowGeometryAt##name(const struct Row* row, int32_t screenOrigin, bool visible) {          \
+        applyRowGeometryAtOriented(row, screenOrigin, visible, horizontal);                                    \
+    }                                                                                                          \
+    static struct GridGeometry getWindowGeometry##name(int32_t rowScreenOrigin, uint32_t rowSize,              \
+                                                       uint32_t windowOrigin, uint32_t windowSize) {           \
+        return getWindowGeometryOriented(rowScreenOrigin, rowSize, windowOrigin, windowSize, horizontal);      \
+    }                                                                                                          \
+    static void getPointerPositionWithScroll##name(const struct Grid* grid, double* longPos, double* latPos) { \
+        getPointerPositionWithScrollOriented(grid, longPos, latPos, horizontal);                               \
+    }                                                                                                          \
+    static const struct Orientation orientation##name = {                                                      \
+        .getLongSize                  = &getLongSize##name,                                                    \
+        .getLatSize                   = &getLatSize##name,                                                     \
+        .getWindowPreferredSize       = &getWindowPreferredSize##name,                                         \
+        .setWindowPreferredSize       = &setWindowPreferredSize##name,                                         \
+        .setRowPreferredSize          = &setRowPreferredSize##name,                                            \
+        .gatherPreferredSizes         = &gatherPreferredSizes##name,                                           \
+        .applyRowGeometryAt           = &applyRowGeometryAt##name,                                             \
+        .getWindowGeometry            = &getWindowGeometry##name,                                              \
+        .getPointerPositionWithScroll = &getPointerPositionWithScroll##name,                                   \
+        .getWindowAbove               = horizontal ? &getWindowPrev : &getWindowParallelPrev,                  \
+        .getWindowBelow               = horizontal ? &getWindowNext : &getWindowParallelNext,                  \
+        .getWindowLeft                = horizontal ? &getWindowParallelPrev : &getWindowPrev,                  \
+        .getWindowRight               = horizontal ? &getWindowParallelNext : &getWindowNext,                  \
+    };
+
+DEFINE_ORIENTATION(Horizontal, true)
+DEFINE_ORIENTATION(Vertical, false)
+
+void grid_init(const struct GridBackend* const gridBackend) {
+    backend = gridBackend;
+    orientation = grid_horizontal ? &orientationHorizontal : &orientationVertical;
+    initPool(&rowPool, sizeof(struct Row));
+    initPool(&windowPool, sizeof(struct Window));
+}
+
+void grid_free() {
+    griddrag_free();
+    destroyPool(&rowPool);
+    destroyPool(&windowPool);
+    free(rowWeights);
+    free(rowSizes);
+    rowWeights = NULL;
+    rowSizes = NULL;
+    rowScratchCapacity = 0;
+}
+
 // getters
 
+const struct GridBackend* getGridBackend() {
+    return backend;
+}
+
 struct Grid* getGrid(wlc_handle const output) {
-    return getOutput(output)->grid;
+    return backend->getGrid(output);
 }
 
 static wlc_handle getGriddedParentView(wlc_handle view) {
     while (view > 0 && !isGridded(view)) {
-        view = wlc_view_get_parent(view);
+        view = backend->getViewParent(view);
     }
     return view;
 }
 
 struct Window* getWindow(wlc_handle const view) {
-    return getView(view)->window;
-}
-
-bool isGriddable(wlc_handle const view) {
-    return !(wlc_view_get_type(view) & ~GRIDDABLE_TYPES);
+    return backend->getWindow(view);
 }
 
 bool isGridded(wlc_handle const view) {
@@ -49,67 +242,279 @@ bool isFloating(wlc_handle const view) {
 }
 
 uint32_t getMaxRowLength(wlc_handle const output) {
-    if (grid_horizontal) {
-        return wlc_output_get_virtual_resolution(output)->h - grid_windowSpacing;
-    } else {
-        return wlc_output_get_virtual_resolution(output)->w - grid_windowSpacing;
-    }
+    return orientation->getLatSize(backend->getOutputSize(output)) - grid_windowSpacing;
 }
 
 uint32_t getPageLength(wlc_handle const output) {
-    if (grid_horizontal) {
-        return wlc_output_get_virtual_resolution(output)->w - grid_windowSpacing;
-    } else {
-        return wlc_output_get_virtual_resolution(output)->h - grid_windowSpacing;
-    }
+    return orientation->getLongSize(backend->getOutputSize(output)) - grid_windowSpacing;
 }
 
 // grid operations
 
-struct Grid* createGrid(wlc_handle output) {
-    struct Grid* grid = malloc(sizeof(struct Grid));
+// forgets all rows, without freeing them
+static void emptyGrid(struct Grid* grid) {
     grid->firstRow = NULL;
     grid->lastRow = NULL;
+    grid->rowIndexRoot = NULL;
+    grid->firstShownRow = NULL;
+    grid->lastShownRow = NULL;
+    grid->layoutDirty = false;
+    grid->dirtyFrom = NULL;
+    grid->firstDirtyRow = NULL;
+}
+
+struct Grid* createGrid(wlc_handle output) {
+    struct Grid* grid = malloc(sizeof(struct Grid));
+    emptyGrid(grid);
+    grid->shownStamp = 1;  // rows start at 0, so they start out as not shown
+    grid->appliedOffset = 0;
     grid->output = output;
+    grid->changeCount = 0;
+    grid->history = NULL;
     grid->scroll = 0.0;
+    return grid;
 }
 
-void destroyGrid(wlc_handle output) {
-    // nothing to do
+void destroyGrid(struct Grid* grid) {
+    assert (grid->firstRow == NULL);  // grid must be evacuated or cleared first
+    freeHistory(grid->history);
+    free(grid);
 }
 
-void layoutGrid(struct Grid* grid) {
-    layoutGridAt(grid->firstRow);
+static int64_t getScrollOffset(const struct Grid* grid) {
+    return llround(grid->scroll);
 }
 
-void layoutGridAt(struct Row* row) {
-    while (row != NULL) {
-        positionRow(row);
-        applyRowGeometry(row);
-        row = row->next;
+static bool isRowOnScreen(int64_t const screenOrigin, uint32_t const size, uint32_t const pageLength) {
+    return screenOrigin <= pageLength && screenOrigin + size >= 0;
+}
+
+// Rows are positioned in 64-bit coordinates, so the grid can grow and scroll without limit, but wlc geometry
+// is 32-bit. Only rows on screen get geometry, and their origin relative to the viewport is bounded by the page,
+// so it's culled in 64 bits and rebased into wlc's range only afterwards.
+// Only a row taller than 2^31 pixels could start out of range, its origin is clamped.
+static int32_t rebaseToScreen(int64_t const screenOrigin) {
+    if (screenOrigin < INT32_MIN) {
+        return INT32_MIN;
     }
+    assert (screenOrigin <= INT32_MAX);  // on screen, so at most pageLength
+    return (int32_t)screenOrigin;
 }
 
-static void applyGridGeometry(struct Grid* grid) {
-    struct Row* row = grid->firstRow;
+// hides rows that were shown, but are not stamped with the current shownStamp
+static void hideRowsNoLongerShown(struct Grid* grid, struct Row* oldFirstShown, const struct Row* oldLastShown) {
+    for (struct Row* row = oldFirstShown; row != NULL; row = row->next) {
+        if (row->shownStamp != grid->shownStamp) {
+            hideRow(row);
+        }
+        if (row == oldLastShown) {
+            break;
+        }
+    }
+}
+
+// Applies geometry only to the rows on screen that might have moved, that is the ones at or after row from
+// (NULL if no row moved), the ones marked dirty and the ones that weren't on screen before. If the scroll offset
+// changed since the last call, all rows on screen are applied. Rows that left the screen are hidden.
+// Cost depends on the number of visible rows, not on the size of the grid.
+static void applyGridGeometryFrom(struct Grid* grid, const struct Row* const from) {
+    struct Row* const oldFirstShown = grid->firstShownRow;
+    struct Row* const oldLastShown = grid->lastShownRow;
+    uint32_t const oldStamp = grid->shownStamp;
+    grid->firstShownRow = NULL;
+    grid->lastShownRow = NULL;
+    grid->shownStamp++;
+
+    int64_t const offset = getScrollOffset(grid);
+    bool const scrolled = offset != grid->appliedOffset;
+    grid->appliedOffset = offset;
+    uint32_t const pageLength = getPageLength(grid->output);
+    struct Row* row = rowIndexFindEndingAfter(grid, offset - 1);
+    if (row != NULL) {
+        size_t position = rowIndexGetPosition(row);
+        size_t const fromPosition = scrolled ? 0 : from == NULL ? SIZE_MAX : rowIndexGetPosition(from);
+        int64_t screenOrigin = getRowOrigin(row) - offset;
+        while (row != NULL && isRowOnScreen(screenOrigin, row->size, pageLength)) {
+            bool const wasShown = row->shownStamp == oldStamp;
+            row->shownStamp = grid->shownStamp;
+            if (grid->firstShownRow == NULL) {
+                grid->firstShownRow = row;
+            }
+            grid->lastShownRow = row;
+            if (position >= fromPosition || !wasShown || row->geometryDirty) {
+                orientation->applyRowGeometryAt(row, rebaseToScreen(screenOrigin), true);
+                row->geometryDirty = false;
+            }
+            screenOrigin += row->size + grid_windowSpacing;
+            position++;
+            row = row->next;
+        }
+    }
+    hideRowsNoLongerShown(grid, oldFirstShown, oldLastShown);
+}
+
+// Grid mutations only mark what they changed, geometry is sent to wlc once per frame by flushGridLayout.
+// This way a burst of changes (e.g. a resize drag with a fast mouse) costs one layout pass per frame.
+
+static void scheduleGridLayout(struct Grid* grid) {
+    backend->scheduleRender(grid->output);
+}
+
+// rows at or after row from moved (NULL if only the scroll might have changed)
+static void invalidateGridFrom(struct Grid* grid, struct Row* const from) {
+    if (from != NULL) {
+        if (grid->dirtyFrom == NULL || rowIndexGetPosition(from) < rowIndexGetPosition(grid->dirtyFrom)) {
+            grid->dirtyFrom = from;
+        }
+    }
+    grid->layoutDirty = true;
+    scheduleGridLayout(grid);
+}
+
+// the history's snapshot of row is outdated
+void rowChanged(struct Row* row) {
+    releaseRowSnapshot(row->snapshot);
+    row->snapshot = NULL;
+    row->parent->changeCount++;
+}
+
+// windows of row changed
+static void invalidateRow(struct Row* row) {
+    rowChanged(row);
+    if (row->geometryDirty) {
+        return;
+    }
+    struct Grid* grid = row->parent;
+    row->geometryDirty = true;
+    row->nextDirtyRow = grid->firstDirtyRow;
+    grid->firstDirtyRow = row;
+    scheduleGridLayout(grid);
+}
+
+void flushGridLayout(struct Grid* grid) {
+    if (grid->layoutDirty) {
+        applyGridGeometryFrom(grid, grid->dirtyFrom);
+        grid->layoutDirty = false;
+        grid->dirtyFrom = NULL;
+    }
+    // dirty rows that weren't on screen
+    struct Row* row = grid->firstDirtyRow;
     while (row != NULL) {
-        applyRowGeometry(row);
-        row = row->next;
+        struct Row* const next = row->nextDirtyRow;
+        if (row->geometryDirty) {
+            applyRowGeometry(row);
+            row->geometryDirty = false;
+        }
+        row->nextDirtyRow = NULL;
+        row = next;
     }
+    grid->firstDirtyRow = NULL;
 }
 
+// Edges held by the pointer and the compositor may refer to moved or freed rows now
+void invalidateEdges(bool const windowsFreed) {
+    gridDragHandleEdgesInvalidated(windowsFreed);
+    backend->edgesInvalidated(windowsFreed);
+}
+
+// closes all views and frees all rows and windows at once, without relayouting or refocusing after each one
 static void clearGrid(struct Grid* grid) {
-    while (grid->firstRow != NULL) {
-        struct Row* row = grid->firstRow;
-        while (row->firstWindow != NULL) {
-            struct Window* window = row->firstWindow;
+    invalidateEdges(true);
+
+    struct Row* row = grid->firstRow;
+    while (row != NULL) {
+        struct Row* const nextRow = row->next;
+        struct Window* window = row->firstWindow;
+        while (window != NULL) {
+            struct Window* const nextWindow = window->next;
             wlc_handle const view = window->view;
-            wlc_view_close(view);
-            destroyWindow(view);
-            // window is freed by function destroyWindow
+            backend->forgetWindow(view);  // so that destroyWindow ignores the view once it's closed
+            backend->closeView(view);
+            poolFree(&windowPool, window);
+            window = nextWindow;
+        }
+        freeRow(row);
+        row = nextRow;
+    }
+    emptyGrid(grid);
+}
+
+// moves all rows of grid to the end of targetGrid in O(n), the target is relayouted once
+static void spliceGrid(struct Grid* grid, struct Grid* targetGrid) {
+    struct Row* const firstMoved = grid->firstRow;
+    if (firstMoved == NULL) {
+        return;
+    }
+    invalidateEdges(true);
+
+    firstMoved->prev = targetGrid->lastRow;
+    if (targetGrid->lastRow == NULL) {
+        targetGrid->firstRow = firstMoved;
+    } else {
+        targetGrid->lastRow->next = firstMoved;
+    }
+    targetGrid->lastRow = grid->lastRow;
+    targetGrid->changeCount++;
+    rowIndexAppend(targetGrid, grid);
+    emptyGrid(grid);
+
+    for (struct Row* row = firstMoved; row != NULL; row = row->next) {
+        row->parent = targetGrid;
+        row->shownStamp = 0;
+        row->geometryDirty = false;
+        row->nextDirtyRow = NULL;
+        for (struct Window* window = row->firstWindow; window != NULL; window = window->next) {
+            backend->setViewOutput(window->view, targetGrid->output);
+            window->appliedGeometryValid = false;
+            window->appliedMaskValid = false;
         }
-        // row is freed by function destroyWindow
+        resizeWindowsIfNecessary(row);  // row length depends on the output
     }
+    invalidateGridFrom(targetGrid, firstMoved);
+}
+
+// Replaces the rows of grid with rowCount new ones, row i gets the next rowWindowCounts[i] of windows and
+// the size rowSizes[i]. windows must hold every window of the grid once. Like any other change, the geometry is
+// applied by the next flush, in a single pass.
+void rebuildGrid(struct Grid* grid, struct Window* const* windows, const size_t* rowWindowCounts,
+                 const uint32_t* rowSizes, size_t const rowCount, double const scroll) {
+    invalidateEdges(true);
+    struct Row* row = grid->firstRow;
+    while (row != NULL) {
+        struct Row* const nextRow = row->next;
+        freeRow(row);
+        row = nextRow;
+    }
+    emptyGrid(grid);
+    grid->changeCount++;
+
+    // windows that were shown keep their masks until the flush, which hides the ones whose rows aren't shown,
+    // as all new rows are marked dirty by layoutRow
+    size_t w = 0;
+    for (size_t i = 0; i < rowCount; i++) {
+        assert (rowWindowCounts[i] > 0);  // rows are never empty
+        row = allocRow(rowSizes[i]);
+        ensureMinSize(&row->size);
+        linkRowAfter(row, grid, grid->lastRow);
+        for (size_t j = 0; j < rowWindowCounts[i]; j++) {
+            struct Window* const window = windows[w++];
+            window->parent = row;
+            window->prev = row->lastWindow;
+            window->next = NULL;
+            if (row->lastWindow == NULL) {
+                row->firstWindow = window;
+            } else {
+                row->lastWindow->next = window;
+            }
+            row->lastWindow = window;
+        }
+        row->windowCount = rowWindowCounts[i];
+        resizeWindowsIfNecessary(row);
+    }
+
+    grid->scroll = scroll;
+    ensureSensibleScroll(grid);
+    invalidateGridFrom(grid, grid->firstRow);
 }
 
 // row operations
@@ -119,6 +524,21 @@ void addRowToGrid(struct Row* row, struct Grid* grid) {
 }
 
 void addRowToGridAfter(struct Row* row, struct Grid* grid, struct Row* prev) {
+    linkRowAfter(row, grid, prev);
+    invalidateGridFrom(grid, row);
+    invalidateRow(row);  // in case it's placed off screen
+}
+
+void removeRow(struct Row* row) {
+    struct Grid* grid = row->parent;
+    struct Row* below = row->next;
+    unlinkRow(row);
+    ensureSensibleScroll(grid);
+    invalidateGridFrom(grid, below);
+}
+
+// inserts row into the grid's list and index, without marking anything for layout
+void linkRowAfter(struct Row* row, struct Grid* grid, struct Row* prev) {
     // row must not yet be in a Grid
     assert (row->prev == NULL);
     assert (row->next == NULL);
@@ -145,17 +565,44 @@ void addRowToGridAfter(struct Row* row, struct Grid* grid, struct Row* prev) {
     if (next != NULL) {
         next->prev = row;
     }
-
-    layoutGridAt(row);
+    rowIndexInsertAfter(grid, row, prev);
+    grid->changeCount++;
 }
 
-void removeRow(struct Row* row) {
+// removes row from the grid's list and index, without marking anything for layout
+void unlinkRow(struct Row* row) {
     struct Grid* grid = row->parent;
     struct Row* above = row->prev;
     struct Row* below = row->next;
+    grid->changeCount++;
+
+    // keep the shown range and the dirty marks valid
+    if (grid->dirtyFrom == row) {
+        grid->dirtyFrom = below;
+    }
+    if (row->geometryDirty) {
+        struct Row** link = &grid->firstDirtyRow;
+        while (*link != row) {
+            link = &(*link)->nextDirtyRow;
+        }
+        *link = row->nextDirtyRow;
+        row->nextDirtyRow = NULL;
+        row->geometryDirty = false;
+    }
+    if (grid->firstShownRow == row && grid->lastShownRow == row) {
+        grid->firstShownRow = NULL;
+        grid->lastShownRow = NULL;
+    } else if (grid->firstShownRow == row) {
+        grid->firstShownRow = below;
+    } else if (grid->lastShownRow == row) {
+        grid->lastShownRow = above;
+    }
+    rowIndexRemove(grid, row);
+
     row->prev = NULL;  // probably unnecessary (except for asserts)
     row->next = NULL;  // probably unnecessary (except for asserts)
     row->parent = NULL;  // unnecessary        (except for asserts)
+    row->shownStamp = 0;
 
     if (grid->firstRow == row) {
         grid->firstRow = below;
@@ -169,68 +616,108 @@ void removeRow(struct Row* row) {
     }
     if (below != NULL) {
         below->prev = above;
-        layoutGridAt(below);
     }
-    ensureSensibleScroll(grid);
+}
+
+static void ensureRowScratchCapacity(size_t const windowCount) {
+    if (windowCount > rowScratchCapacity) {
+        rowScratchCapacity = windowCount * 2;
+        rowWeights = realloc(rowWeights, rowScratchCapacity * sizeof(uint32_t));
+        rowSizes = realloc(rowSizes, rowScratchCapacity * sizeof(uint32_t));
+    }
+}
+
+// Distributes length over sizes in proportion to weights, in integer arithmetic.
+// Element i ends at length * (weights[0] + ... + weights[i]) / totalWeight (rounded down), so the sizes
+// always sum up to exactly length and the same weights always give the same sizes.
+static void distributeLength(const uint32_t* restrict const weights, uint32_t* restrict const sizes, size_t const count,
+                             uint64_t const totalWeight, uint64_t const length) {
+    uint64_t cumulativeWeight = 0;
+    uint64_t previousEnd = 0;
+    for (size_t i = 0; i < count; i++) {
+        cumulativeWeight += weights[i];
+        uint64_t const end = cumulativeWeight * length / totalWeight;
+        sizes[i] = (uint32_t)(end - previousEnd);
+        previousEnd = end;
+    }
+}
+
+// sizes of windowCount windows with the preferred sizes in rowWeights, in a row on output
+static const uint32_t* computeRowSizes(size_t const windowCount, uint64_t preferredSizeSum, wlc_handle const output) {
+    int64_t const available = (int64_t)getMaxRowLength(output) - (int64_t)windowCount * grid_windowSpacing;
+    uint64_t const maxRowLength = available < 0 ? 0 : (uint64_t)available;
+
+    if (preferredSizeSum <= maxRowLength && !grid_minimizeEmptySpace) {
+        return rowWeights;
+    }
+    if (preferredSizeSum == 0) {
+        // views without a size yet, share equally
+        for (size_t i = 0; i < windowCount; i++) {
+            rowWeights[i] = 1;
+        }
+        preferredSizeSum = windowCount;
+    }
+    distributeLength(rowWeights, rowSizes, windowCount, preferredSizeSum, maxRowLength);
+    return rowSizes;
 }
 
 void resizeWindowsIfNecessary(struct Row* const row) {
     assert (row->firstWindow != NULL);  // rows are never empty
     assert (row->lastWindow  != NULL);  // rows are never empty
-    uint32_t windowsSizeSum = 0;
-    uint32_t windowsPreferredSizeSum = 0;
-    uint32_t maxRowLength = getMaxRowLength(row->parent->output);
-    struct Window* window = row->firstWindow;
-    while (window != NULL) {
-        uint32_t const preferredSize = getWindowPreferredSize(window);
-        windowsSizeSum += window->size;
-        windowsPreferredSizeSum += preferredSize;
-        maxRowLength -= grid_windowSpacing;
-        window->size = preferredSize;
-        window = window->next;
-    }
-    if (windowsPreferredSizeSum > maxRowLength || grid_minimizeEmptySpace) {
-        double ratio = (double)maxRowLength / windowsPreferredSizeSum;
-        window = row->firstWindow;
-        while (window != NULL) {
-            window->size = (uint32_t)round(getWindowPreferredSize(window) * ratio);
-            window = window->next;
-        }
+
+    uint64_t preferredSizeSum;
+    size_t const windowCount = orientation->gatherPreferredSizes(row, &preferredSizeSum);
+    const uint32_t* const sizes = computeRowSizes(windowCount, preferredSizeSum, row->parent->output);
+
+    size_t i = 0;
+    for (struct Window* window = row->firstWindow; window != NULL; window = window->next) {
+        window->size = sizes[i++];
     }
     layoutRow(row);
 }
 
-// creates a new Row to house view
-struct Row* createRow(wlc_handle view) {
-    struct Grid* grid = getGrid(wlc_view_get_output(view));
-
-    struct wlc_size const viewSize = wlc_view_get_geometry(view)->size;
-    uint32_t rowSize = grid_horizontal ? viewSize.w : viewSize.h;
-    
-    struct Row* row = malloc(sizeof(struct Row));
+struct Row* allocRow(uint32_t const size) {
+    struct Row* row = poolAlloc(&rowPool);
     row->prev = NULL;         // probably unnecessary (except for asserts)
     row->next = NULL;         // probably unnecessary (except for asserts)
     row->firstWindow = NULL;
     row->lastWindow = NULL;
     row->parent = NULL;       // probably unnecessary (except for asserts)
-    row->size = rowSize;
+    row->size = size;
+    row->shownStamp = 0;
+    row->windowIndex = NULL;
+    row->windowCount = 0;
+    row->windowIndexCapacity = 0;
+    row->geometryDirty = false;
+    row->nextDirtyRow = NULL;
+    row->snapshot = NULL;
+    return row;
+}
+
+void freeRow(struct Row* row) {
+    releaseRowSnapshot(row->snapshot);
+    free(row->windowIndex);
+    poolFree(&rowPool, row);
+}
+
+// creates a new Row to house view
+struct Row* createRow(wlc_handle view) {
+    struct Grid* grid = getGrid(backend->getViewOutput(view));
+
+    struct GridSize const viewSize = backend->getViewGeometry(view).size;
+    uint32_t rowSize = orientation->getLongSize(viewSize);
     
+    struct Row* row = allocRow(rowSize);
     addRowToGrid(row, grid);
     return row;
 }
 struct Row* createRowAndPlaceAfter(wlc_handle view, struct Row* prev) {
-    struct Grid* grid = getGrid(wlc_view_get_output(view));
+    struct Grid* grid = getGrid(backend->getViewOutput(view));
 
-    struct wlc_size const viewSize = wlc_view_get_geometry(view)->size;
-    uint32_t rowSize = grid_horizontal ? viewSize.w : viewSize.h;
+    struct GridSize const viewSize = backend->getViewGeometry(view).size;
+    uint32_t rowSize = orientation->getLongSize(viewSize);
 
-    struct Row* row = malloc(sizeof(struct Row));
-    row->prev = NULL;         // probably unnecessary (except for asserts)
-    row->next = NULL;         // probably unnecessary (except for asserts)
-    row->firstWindow = NULL;
-    row->lastWindow = NULL;
-    row->parent = NULL;       // probably unnecessary (except for asserts)
-    row->size = rowSize;
+    struct Row* row = allocRow(rowSize);
 
     addRowToGridAfter(row, grid, prev);
     return row;
@@ -241,33 +728,63 @@ bool isLastRow(const struct Row* row) {
     return row->parent->lastRow == row;
 }
 
-bool isRowEdge(enum wlc_resize_edge edge) {
-    bool horizontalEdge = edge & (WLC_RESIZE_EDGE_TOP | WLC_RESIZE_EDGE_BOTTOM);
-    return !grid_horizontal != !horizontalEdge;  // ! converts to bool (0 or 1)
-}
-
 void layoutRow(struct Row* row) {
+    size_t windowCount = 0;
     struct Window* window = row->firstWindow;
     while (window != NULL) {
         positionWindow(window);
+        windowCount++;
         window = window->next;
     }
-    applyRowGeometry(row);
+    assert (windowCount == row->windowCount);
+    indexRowWindows(row, windowCount);
+    invalidateRow(row);
 }
 
-void positionRow(struct Row* row) {
-    if (row->prev == NULL) {
-        row->origin = grid_windowSpacing;
-    } else {
-        row->origin = row->prev->origin + grid_windowSpacing + row->prev->size;
+// windowIndex holds the row's windows in order, for binary searches by position
+void indexRowWindows(struct Row* row, size_t const windowCount) {
+    if (windowCount > row->windowIndexCapacity) {
+        row->windowIndexCapacity = windowCount * 2;
+        row->windowIndex = realloc(row->windowIndex, row->windowIndexCapacity * sizeof(struct Window*));
+    }
+    size_t i = 0;
+    for (struct Window* window = row->firstWindow; window != NULL; window = window->next) {
+        row->windowIndex[i++] = window;
     }
+    row->windowCount = windowCount;
+}
+
+// returns the index of the first window with origin + size > latPos, or windowCount if there is none
+size_t findWindowEndingAfter(const struct Row* row, double const latPos) {
+    size_t low = 0;
+    size_t high = row->windowCount;
+    while (low < high) {
+        size_t const mid = low + (high - low) / 2;
+        const struct Window* const window = row->windowIndex[mid];
+        if (window->origin + window->size > latPos) {
+            high = mid;
+        } else {
+            low = mid + 1;
+        }
+    }
+    return low;
+}
+
+int64_t getRowOrigin(const struct Row* row) {
+    return rowIndexGetOrigin(row);
 }
 
 void applyRowGeometry(const struct Row* row) {
-    struct Window* window = row->firstWindow;
-    while (window != NULL) {
-        applyWindowGeometry(window);
-        window = window->next;
+    const struct Grid* grid = row->parent;
+    int64_t const screenOrigin = getRowOrigin(row) - getScrollOffset(grid);
+    bool const visible = isRowOnScreen(screenOrigin, row->size, getPageLength(grid->output));
+    // hidden rows only get masked, their origin is never sent
+    orientation->applyRowGeometryAt(row, visible ? rebaseToScreen(screenOrigin) : 0, visible);
+}
+
+void hideRow(const struct Row* row) {
+    for (struct Window* window = row->firstWindow; window != NULL; window = window->next) {
+        setWindowMask(window, 0);
     }
 }
 
@@ -275,13 +792,13 @@ void scrollToRow(const struct Row* row) {
     struct Grid* const grid = row->parent;
     uint32_t const screenLength = getPageLength(grid->output);
 
-    int32_t const row_top = row->origin;
-    int32_t const row_btm = row_top + row->size;
-    int32_t const screen_top = (int32_t)grid->scroll;
-    int32_t const screen_btm = screen_top + screenLength;
+    int64_t const row_top = getRowOrigin(row);
+    int64_t const row_btm = row_top + row->size;
+    int64_t const screen_top = (int64_t)grid->scroll;
+    int64_t const screen_btm = screen_top + screenLength;
 
-    int32_t const margin_top = row_top - screen_top;
-    int32_t const margin_btm = screen_btm - row_btm;
+    int64_t const margin_top = row_top - screen_top;
+    int64_t const margin_btm = screen_btm - row_btm;
 
     if (margin_top < 0) {
         // row is above the screen
@@ -304,52 +821,78 @@ void scrollToRow(const struct Row* row) {
     }
 
     // do scroll
-    applyGridGeometry(grid);
+    applyScroll(grid);
 
-    hoveredEdge = NULL;
+    invalidateEdges(false);
 }
 
 void resizeRow(struct Row* row, int32_t sizeDelta) {
     row->size += sizeDelta;
     ensureMinSize(&row->size);
-    for (struct Window* window = row->firstWindow; window != NULL; window = window->next) {
-        if (grid_horizontal) {
-            window->preferredWidth = row->size;
-        } else {
-            window->preferredHeight = row->size;
-        }
-    }
-    layoutGridAt(row);
+    orientation->setRowPreferredSize(row);
+    rowChanged(row);
+    rowIndexUpdate(row);
+    invalidateGridFrom(row->parent, row);
 }
 
 // window operations
 
-struct Window* createWindow(wlc_handle const view) {
-    if (!isGriddable(view)) {
-        return NULL;
-    }
-    wlc_handle const output = wlc_view_get_output(view);
-    assert (getGrid(output) != NULL);  // grid already created by function output_created
-
-    struct wlc_size const viewSize = wlc_view_get_geometry(view)->size;
-    uint32_t windowSize = grid_horizontal ? viewSize.h : viewSize.w;
-
-    struct Window* window = malloc(sizeof(struct Window));
+struct Window* allocWindow(wlc_handle const view, uint32_t const preferredWidth, uint32_t const preferredHeight) {
+    struct Window* window = poolAlloc(&windowPool);
     window->prev   = NULL;  // probably unnecessary (except for asserts)
     window->next   = NULL;  // probably unnecessary (except for asserts)
     window->parent = NULL;  // probably unnecessary (except for asserts)
     window->view = view;
-    window->size = windowSize;
-    window->preferredWidth = viewSize.w;
-    window->preferredHeight = viewSize.h;
+    window->preferredWidth = preferredWidth;
+    window->preferredHeight = preferredHeight;
+    window->size = getWindowPreferredSize(window);
+    window->appliedMaskValid = false;
+    window->appliedGeometryValid = false;
+    return window;
+}
+
+struct Window* createWindow(wlc_handle const view) {
+    wlc_handle const output = backend->getViewOutput(view);
+    assert (getGrid(output) != NULL);  // grid already created by function output_created
+
+    struct GridSize const viewSize = backend->getViewGeometry(view).size;
+    struct Window* window = allocWindow(view, viewSize.w, viewSize.h);
 
     struct Row* row = createRow(view);
     addWindowToRow(window, row);
     return window;
 }
 
+// places the window straight where it belongs, so it's configured once rather than created in a row of its own and moved
+struct Window* createWindowAt(wlc_handle const view, const struct WindowPlacement* const placement) {
+    struct Grid* const grid = getGrid(backend->getViewOutput(view));
+    assert (grid != NULL);  // grid already created by function output_created
+    struct Window* const neighbor = placement->neighbor;
+    assert (neighbor == NULL || neighbor->parent->parent == grid);
+
+    struct Window* window = allocWindow(view, placement->preferredWidth, placement->preferredHeight);
+    if (neighbor != NULL && placement->sameRow) {
+        addWindowToRowAfter(window, neighbor->parent, placement->before ? neighbor->prev : neighbor);
+        return window;
+    }
+
+    uint32_t rowSize = placement->rowSize;
+    if (rowSize == 0) {
+        rowSize = orientation->getLongSize(backend->getViewGeometry(view).size);
+    }
+    ensureMinSize(&rowSize);
+    struct Row* prev = grid->lastRow;
+    if (neighbor != NULL) {
+        prev = placement->before ? neighbor->parent->prev : neighbor->parent;
+    }
+    struct Row* row = allocRow(rowSize);
+    addRowToGridAfter(row, grid, prev);
+    addWindowToRow(window, row);
+    return window;
+}
+
 void destroyWindow(wlc_handle const view) {
-    hoveredEdge = NULL;
+    invalidateEdges(false);
 
     struct Window* window = getWindow(view);
     if (window == NULL) {
@@ -368,12 +911,12 @@ void destroyWindow(wlc_handle const view) {
         nextWindow = getWindowParallelPrev(window);
     }
     if (nextWindow != NULL) {
-        wlc_view_focus(nextWindow->view);
+        backend->focusView(nextWindow->view);
     }
 
     // free
     removeWindow(window);
-    free(window);
+    poolFree(&windowPool, window);
 }
 
 bool isLastWindow(const struct Window* window) {
@@ -423,6 +966,7 @@ void addWindowToRowAfter(struct Window* window, struct Row* row, struct Window*
     if (next != NULL) {
         next->prev = window;
     }
+    row->windowCount++;
     resizeWindowsIfNecessary(row);
 }
 
@@ -447,12 +991,13 @@ void removeWindow(struct Window* const window) {
     if (row->lastWindow == window) {
         row->lastWindow = left;
     }
+    row->windowCount--;
 
     if (row->firstWindow == NULL) {
         assert (row->lastWindow == NULL);
         // destroy row if empty
         removeRow(row);
-        free(row);
+        freeRow(row);
     } else {
         assert (row->lastWindow != NULL);
         // otherwise recalculate window sizes and positions
@@ -470,36 +1015,37 @@ void positionWindow(struct Window* window) {
     }
 }
 
-void applyWindowGeometry(const struct Window* window) {
-    struct Row* row = window->parent;
-    uint32_t offset = -(uint32_t)round(row->parent->scroll);
-    struct wlc_geometry geometry;
+// the last mask and geometry sent are cached per window, so unchanged views don't get configured again
 
-    // hide offscreen views
-    const uint32_t pageLength = getPageLength(window->parent->parent->output);
-    const bool visible = (int32_t)(row->origin + offset) <= (int32_t)pageLength &&
-                         (int32_t)(row->origin + offset + row->size) >= 0;
-    wlc_view_set_mask(window->view, (uint32_t)visible);
+static void setWindowMask(struct Window* window, uint32_t const mask) {
+    if (window->appliedMaskValid && window->appliedMask == mask) {
+        geometryStats.masksSuppressed++;
+        return;
+    }
+    backend->setViewMask(window->view, mask);
+    window->appliedMask = mask;
+    window->appliedMaskValid = true;
+    geometryStats.masksSent++;
+}
 
-    if (visible) {
-        // calculate geometry
-        if (grid_horizontal) {
-            geometry.origin.x = row->origin + offset;
-            geometry.origin.y = window->origin;
-            geometry.size.w = row->size;
-            geometry.size.h = window->size;
-        } else {
-            geometry.origin.x = window->origin;
-            geometry.origin.y = row->origin + offset;
-            geometry.size.w = window->size;
-            geometry.size.h = row->size;
-        }
-        wlc_view_set_geometry(window->view, 0, &geometry);
+static bool geometryEquals(const struct GridGeometry* a, const struct GridGeometry* b) {
+    return a->origin.x == b->origin.x && a->origin.y == b->origin.y &&
+           a->size.w   == b->size.w   && a->size.h   == b->size.h;
+}
+
+static void setWindowGeometry(struct Window* window, const struct GridGeometry* geometry) {
+    if (window->appliedGeometryValid && geometryEquals(&window->appliedGeometry, geometry)) {
+        geometryStats.geometriesSuppressed++;
+        return;
     }
+    backend->setViewGeometry(window->view, geometry);
+    window->appliedGeometry = *geometry;
+    window->appliedGeometryValid = true;
+    geometryStats.geometriesSent++;
 }
 
 uint32_t getWindowPreferredSize(const struct Window* window) {
-    return grid_horizontal ? window->preferredHeight : window->preferredWidth;
+    return orientation->getWindowPreferredSize(window);
 }
 
 void resizeWindow(struct Window* window, int32_t sizeDelta) {
@@ -547,20 +1093,17 @@ void resizeWindow(struct Window* window, int32_t sizeDelta) {
 
     // apply new geometry
     window->size += sizeDelta;
-    if (grid_horizontal) {
-        window->preferredHeight = window->size;
-    } else {
-        window->preferredWidth = window->size;
-    }
+    orientation->setWindowPreferredSize(window, window->size);
     layoutRow(window->parent);
 }
 
 static void resetWindowSize(struct Window* window) {
-    struct wlc_geometry geom;
-    geom.origin = wlc_view_get_geometry(window->view)->origin;
+    struct GridGeometry geom;
+    geom.origin = backend->getViewGeometry(window->view).origin;
     geom.size.w = window->preferredWidth;
     geom.size.h = window->preferredHeight;
-    wlc_view_set_geometry(window->view, 0, &geom);
+    backend->setViewGeometry(window->view, &geom);
+    window->appliedGeometryValid = false;
 }
 
 // presentation
@@ -571,7 +1114,7 @@ void printGrid(const struct Grid* grid) {
     while (row != NULL) {
         struct Window* window = row->firstWindow;
         while (window != NULL) {
-            fprintf(stderr, "%d ", window->view);
+            fprintf(stderr, "%" PRIuPTR " ", window->view);
             window = window->next;
         }
         fprintf(stderr, "\n");
@@ -579,22 +1122,38 @@ void printGrid(const struct Grid* grid) {
     }
 }
 
+void printGeometryStats() {
+    fprintf(stderr, "Geometry updates sent: %lu, suppressed: %lu\n",
+            (unsigned long)geometryStats.geometriesSent, (unsigned long)geometryStats.geometriesSuppressed);
+    fprintf(stderr, "Mask updates sent: %lu, suppressed: %lu\n",
+            (unsigned long)geometryStats.masksSent, (unsigned long)geometryStats.masksSuppressed);
+}
+
 void scrollGrid(struct Grid* grid, double amount) {
     grid->scroll += amount;
     ensureSensibleScroll(grid);
-    hoveredEdge = NULL;
+    applyScroll(grid);
+    invalidateEdges(false);
+}
+
+// moves the views on screen to the current scroll, row positions are left as they are
+void applyScroll(struct Grid* grid) {
+    if (getScrollOffset(grid) == grid->appliedOffset) {
+        // sub-pixel scroll, nothing to move
+        return;
+    }
+    invalidateGridFrom(grid, NULL);
 }
 
 void ensureSensibleScroll(struct Grid* grid) {
     if (grid->scroll < 0.0) {
         grid->scroll = 0.0;
     } else {
-        const struct Row* const lastRow = grid->lastRow;
-        if (lastRow == NULL) {
+        if (grid->lastRow == NULL) {
             // grid is empty, can't scroll
             grid->scroll = 0.0;
         } else {
-            int32_t const overflow = (lastRow->origin + lastRow->size) - getPageLength(grid->output);
+            int64_t const overflow = rowIndexGetLength(grid) - getPageLength(grid->output);
             if (overflow < 0) {
                 grid->scroll = 0.0;
             } else if (grid->scroll > overflow) {
@@ -602,84 +1161,101 @@ void ensureSensibleScroll(struct Grid* grid) {
             }
         }
     }
-    layoutGrid(grid);
 }
 
 // neighboring Windows
 
-struct Window* getWindowParallelPrev(const struct Window* window) {
-    // TODO: determine closest
-    if (window->parent->prev == NULL) {
-        return NULL;
+// Windows in a row don't overlap and windowIndex holds them in order, so it serves as the row's interval index.
+// Returns the window of row whose span contains latPos, or the nearest one if latPos falls between windows.
+struct Window* getWindowNearest(const struct Row* row, double const latPos) {
+    size_t const i = findWindowEndingAfter(row, latPos);
+    if (i == row->windowCount) {
+        // after the last window
+        return row->lastWindow;
+    }
+    struct Window* const after = row->windowIndex[i];
+    if (i > 0 && latPos < after->origin) {
+        // in the spacing between two windows
+        struct Window* const before = row->windowIndex[i - 1];
+        if (latPos - (before->origin + before->size) < after->origin - latPos) {
+            return before;
+        }
     }
-    return window->parent->prev->firstWindow;
+    return after;
 }
 
-struct Window* getWindowParallelNext(const struct Window* window) {
-    // TODO: determine closest
-    if (window->parent->next == NULL) {
-        return NULL;
-    }
-    return window->parent->next->firstWindow;
+static double getWindowMidpoint(const struct Window* window) {
+    return window->origin + window->size / 2.0;
 }
 
-struct Window* getWindowAbove(const struct Window* window) {
-    if (grid_horizontal) {
-        return window->prev;
+struct Window* getWindowParallelPrev(const struct Window* window) {
+    if (window->parent->prev == NULL) {
+        return NULL;
     }
-    return getWindowParallelPrev(window);
+    return getWindowNearest(window->parent->prev, getWindowMidpoint(window));
 }
 
-struct Window* getWindowBelow(const struct Window* window) {
-    if (grid_horizontal) {
-        return window->next;
-    }
-    return getWindowParallelNext(window);
+struct Window* getWindowPrev(const struct Window* window) {
+    return window->prev;
 }
 
-struct Window* getWindowLeft(const struct Window* window) {
-    if (grid_horizontal) {
-        return getWindowParallelPrev(window);
-    }
-    return window->prev;
+struct Window* getWindowNext(const struct Window* window) {
+    return window->next;
 }
 
-struct Window* getWindowRight(const struct Window* window) {
-    if (grid_horizontal) {
-        return getWindowParallelNext(window);
+struct Window* getWindowParallelNext(const struct Window* window) {
+    if (window->parent->next == NULL) {
+        return NULL;
     }
-    return window->next;
+    return getWindowNearest(window->parent->next, getWindowMidpoint(window));
 }
 
 // view management
 
-void focusRow(size_t const index, wlc_handle const currentView) {
-    // get selected row
-    const struct Row* selectedRow = getGrid(wlc_get_focused_output())->firstRow;
-    for (size_t i = 0; i < index && selectedRow != NULL; i++) {
-        selectedRow = selectedRow->next;
-    }
-    if (selectedRow == NULL) {
-        return;
-    }
-
+static void focusSelectedRow(const struct Row* const selectedRow, wlc_handle const currentView) {
     // if already in selected row, move focus to its next window
     const struct Window* const currentWindow = getWindow(getGriddedParentView(currentView));
     if (currentWindow != NULL) {
         const struct Row* const currentRow = currentWindow->parent;
         if (currentRow == selectedRow && currentWindow->next != NULL) {
             // focus next window
-            wlc_view_focus(currentWindow->next->view);
+            backend->focusView(currentWindow->next->view);
             return;
         }
     }
 
     // focus selected row
     assert(selectedRow->firstWindow != NULL);
-    wlc_view_focus(selectedRow->firstWindow->view);
+    backend->focusView(selectedRow->firstWindow->view);
+}
+
+void focusRow(size_t const index, wlc_handle const currentView) {
+    const struct Row* const selectedRow = rowIndexGetAt(getGrid(backend->getFocusedOutput()), index);
+    if (selectedRow == NULL) {
+        return;
+    }
+    focusSelectedRow(selectedRow, currentView);
+}
+
+void focusRowRelative(int32_t const delta, wlc_handle const currentView) {
+    const struct Window* const currentWindow = getWindow(getGriddedParentView(currentView));
+    if (currentWindow == NULL) {
+        return;
+    }
+    const struct Row* const currentRow = currentWindow->parent;
+    int64_t index = (int64_t)rowIndexGetPosition(currentRow) + delta;
+    int64_t const rowCount = rowIndexGetCount(currentRow->parent);
+    if (index < 0) {
+        index = 0;
+    } else if (index >= rowCount) {
+        index = rowCount - 1;
+    }
+    const struct Row* const selectedRow = rowIndexGetAt(currentRow->parent, (size_t)index);
+    if (selectedRow != currentRow) {
+        focusSelectedRow(selectedRow, currentView);
+    }
 }
 
-typedef struct Window* (*WindowNeighborGetter)(const struct Window* window);
 static void focusViewInner(wlc_handle const view, WindowNeighborGetter getNeighbor) {
     const struct Window* currentWindow = getWindow(getGriddedParentView(view));
     if (currentWindow == NULL) {
@@ -687,20 +1263,20 @@ static void focusViewInner(wlc_handle const view, WindowNeighborGetter getNeighb
     }
     const struct Window* targetWindow = getNeighbor(currentWindow);
     if (targetWindow != NULL) {
-        wlc_view_focus(targetWindow->view);
+        backend->focusView(targetWindow->view);
     }
 }
 void focusViewAbove(wlc_handle const view) {
-    focusViewInner(view, &getWindowAbove);
+    focusViewInner(view, orientation->getWindowAbove);
 }
 void focusViewBelow(wlc_handle const view) {
-    focusViewInner(view, &getWindowBelow);
+    focusViewInner(view, orientation->getWindowBelow);
 }
 void focusViewLeft(wlc_handle const view) {
-    focusViewInner(view, &getWindowLeft);
+    focusViewInner(view, orientation->getWindowLeft);
 }
 void focusViewRight(wlc_handle const view) {
-    focusViewInner(view, &getWindowRight);
+    focusViewInner(view, orientation->getWindowRight);
 }
 
 // returns true if correct action done
@@ -736,48 +1312,81 @@ static void moveViewInner(wlc_handle const view, WindowNeighborGetter const getN
     }
 }
 void moveViewUp(wlc_handle const view) {
-    moveViewInner(view, &getWindowAbove, grid_horizontal, false);
+    moveViewInner(view, orientation->getWindowAbove, grid_horizontal, false);
 }
 void moveViewDown(wlc_handle const view) {
-    moveViewInner(view, &getWindowBelow, grid_horizontal, true);
+    moveViewInner(view, orientation->getWindowBelow, grid_horizontal, true);
 }
 void moveViewLeft(wlc_handle const view) {
-    moveViewInner(view, &getWindowLeft, !grid_horizontal, false);
+    moveViewInner(view, orientation->getWindowLeft, !grid_horizontal, false);
 }
 void moveViewRight(wlc_handle const view) {
-    moveViewInner(view, &getWindowRight, !grid_horizontal, true);
+    moveViewInner(view, orientation->getWindowRight, !grid_horizontal, true);
 }
 
-void moveRowBack(wlc_handle const view) {
-    const struct Window* window = getWindow(view);
-    if (window == NULL) {
-        return;
+// swaps two adjacent rows, only their own geometry changes
+static void swapRows(struct Row* first, struct Row* second) {
+    assert (first->next == second);
+    struct Grid* grid = first->parent;
+    unlinkRow(second);
+    linkRowAfter(second, grid, first->prev);
+    invalidateRow(first);
+    invalidateRow(second);
+    invalidateGridFrom(grid, NULL);  // only to keep track of rows entering or leaving the screen
+}
+
+// moves row by delta positions (clamped to the grid), the rows it passes are shifted by one row each
+static void moveRow(struct Row* row, int32_t const delta) {
+    struct Grid* grid = row->parent;
+    int64_t const position = rowIndexGetPosition(row);
+    int64_t targetPosition = position + delta;
+    int64_t const rowCount = rowIndexGetCount(grid);
+    if (targetPosition < 0) {
+        targetPosition = 0;
+    } else if (targetPosition >= rowCount) {
+        targetPosition = rowCount - 1;
     }
-    struct Row* row = window->parent;
-    if (row->prev == NULL) {
-        // already at the top
+
+    if (targetPosition == position) {
+        // already at the top or bottom
+        return;
+    } else if (targetPosition == position - 1) {
+        swapRows(row->prev, row);
+        return;
+    } else if (targetPosition == position + 1) {
+        swapRows(row, row->next);
         return;
     }
-    struct Grid* grid = row->parent;
-    struct Row* targetRow = row->prev->prev;
-    removeRow(row);
-    addRowToGridAfter(row, grid, targetRow);
+
+    struct Row* firstMoved;
+    struct Row* targetPrev;
+    if (targetPosition > position) {
+        firstMoved = row->next;
+        targetPrev = rowIndexGetAt(grid, (size_t)targetPosition);
+    } else {
+        firstMoved = row;
+        targetPrev = targetPosition == 0 ? NULL : rowIndexGetAt(grid, (size_t)targetPosition - 1);
+    }
+    unlinkRow(row);
+    linkRowAfter(row, grid, targetPrev);
+    invalidateGridFrom(grid, firstMoved);
+    invalidateRow(row);  // in case it's moved off screen
 }
 
-void moveRowForward(wlc_handle const view) {
+void moveRowBy(wlc_handle const view, int32_t const delta) {
     const struct Window* window = getWindow(view);
     if (window == NULL) {
         return;
     }
-    struct Row* row = window->parent;
-    if (row->next == NULL) {
-        // already at the bottom
-        return;
-    }
-    struct Grid* grid = row->parent;
-    struct Row* targetRow = row->next;
-    removeRow(row);
-    addRowToGridAfter(row, grid, targetRow);
+    moveRow(window->parent, delta);
+}
+
+void moveRowBack(wlc_handle const view) {
+    moveRowBy(view, -1);
+}
+
+void moveRowForward(wlc_handle const view) {
+    moveRowBy(view, 1);
 }
 
 void scrollToView(wlc_handle const view) {
@@ -789,71 +1398,7 @@ void scrollToView(wlc_handle const view) {
 }
 
 void getPointerPositionWithScroll(const struct Grid* grid, double* longPos, double* latPos) {
-    double x, y;
-    wlc_pointer_get_position_v2(&x, &y);
-
-    if (grid_horizontal) {
-        *longPos = x + grid->scroll;
-        *latPos = y;
-    } else {
-        *longPos = y + grid->scroll;
-        *latPos = x;
-    }
-}
-
-enum wlc_resize_edge getNearestEdgeOfView(wlc_handle view) {
-    double x, y;
-    wlc_pointer_get_position_v2(&x, &y);
-    const struct wlc_geometry* geom = wlc_view_get_geometry(view);
-    double distToTop = y - geom->origin.y;
-    double distToBtm = geom->origin.y + geom->size.h - y;
-    double distToLeft = x - geom->origin.x;
-    double distToRight = geom->origin.x + geom->size.w - x;
-
-    if (distToTop < distToBtm) {
-        if (distToTop < distToLeft) {
-            if (distToTop < distToRight) {
-                return WLC_RESIZE_EDGE_TOP;
-            } else {
-                return WLC_RESIZE_EDGE_RIGHT;
-            }
-        } else {
-            if (distToLeft < distToRight) {
-                return WLC_RESIZE_EDGE_LEFT;
-            } else {
-                return WLC_RESIZE_EDGE_RIGHT;
-            }
-        }
-    } else {
-        if (distToBtm < distToLeft) {
-            if (distToBtm < distToRight) {
-                return WLC_RESIZE_EDGE_BOTTOM;
-            } else {
-                return WLC_RESIZE_EDGE_RIGHT;
-            }
-        } else {
-            if (distToLeft < distToRight) {
-                return WLC_RESIZE_EDGE_LEFT;
-            } else {
-                return WLC_RESIZE_EDGE_RIGHT;
-            }
-        }
-    }
-}
-
-enum wlc_resize_edge getNearestCornerOfView(wlc_handle view) {
-    double x, y;
-    wlc_pointer_get_position_v2(&x, &y);
-    const struct wlc_geometry* geom = wlc_view_get_geometry(view);
-    double distToTop = y - geom->origin.y;
-    double distToBtm = geom->origin.y + geom->size.h - y;
-    double distToLeft = x - geom->origin.x;
-    double distToRight = geom->origin.x + geom->size.w - x;
-
-    enum wlc_resize_edge closestHorizontalEdge = distToTop < distToBtm ? WLC_RESIZE_EDGE_TOP : WLC_RESIZE_EDGE_BOTTOM;
-    enum wlc_resize_edge closestVerticalEdge = distToLeft < distToRight ? WLC_RESIZE_EDGE_LEFT : WLC_RESIZE_EDGE_RIGHT;
-
-    return closestHorizontalEdge | closestVerticalEdge;
+    orientation->getPointerPositionWithScroll(grid, longPos, latPos);
 }
 
 // bottom edge is considered part of row
@@ -862,26 +1407,24 @@ struct Row* getHoveredRow(const struct Grid* grid) {
     double longPos, latPos;
     getPointerPositionWithScroll(grid, &longPos, &latPos);
 
-    for (struct Row* row = grid->firstRow; row != NULL; row = row->next) {
-        if ((int32_t)row->origin + row->size + grid_windowSpacing > longPos) {
-            return row;
-        }
+    struct Row* row = rowIndexFindEndingAfter(grid, longPos - grid_windowSpacing);
+    if (row == NULL) {
+        return grid->lastRow;
     }
-    assert (grid->firstRow == NULL || longPos > grid->firstRow->origin - grid_windowSpacing);
-    return grid->lastRow;
+    return row;
 }
 
-// free after use
-struct Edge* getNearestEdge(const struct Grid* grid) {
+struct Edge getNearestEdge(const struct Grid* grid) {
     double longPos, latPos;
     getPointerPositionWithScroll(grid, &longPos, &latPos);
 
     struct Row* row_hovered = getHoveredRow(grid);
     if (row_hovered == NULL) {
-        return NULL;
+        return NO_EDGE;
     }
+    int64_t const row_hovered_origin = getRowOrigin(row_hovered);
     struct Row* row_nearestBtmEdge;
-    if (longPos < (int32_t)row_hovered->origin + row_hovered->size / 2) {
+    if (longPos < row_hovered_origin + row_hovered->size / 2) {
         // cursor in the upper half of row_hovered
         row_nearestBtmEdge = row_hovered->prev;
 
@@ -889,102 +1432,80 @@ struct Edge* getNearestEdge(const struct Grid* grid) {
         // cursor in the lower half of row_hovered
         row_nearestBtmEdge = row_hovered;
 
-        if (longPos > (int32_t)row_hovered->origin + row_hovered->size + grid_windowSpacing) {
+        if (longPos > row_hovered_origin + row_hovered->size + grid_windowSpacing) {
             assert (isLastRow(row_hovered));
             // cursor below row, don't check windows
-            struct Edge* retval = malloc(sizeof(struct Edge));
-            retval->type = EDGE_ROW;
-            retval->row = row_nearestBtmEdge;
-            retval->window = NULL;
-            return retval;
+            return (struct Edge){EDGE_ROW, row_nearestBtmEdge, NULL};
         }
     }
 
     double rowEdgePos = grid_windowSpacing / 2;
     if (row_nearestBtmEdge != NULL) {
-        rowEdgePos += (int32_t)row_nearestBtmEdge->origin + row_nearestBtmEdge->size;
+        rowEdgePos += getRowOrigin(row_nearestBtmEdge) + row_nearestBtmEdge->size;
     }
     double const distToRowEdge = fabs(rowEdgePos - longPos);
 
     assert (row_hovered->lastWindow != NULL);  // rows can't be empty
     if (distToRowEdge > ROW_EDGE_GRAB_SIZE && latPos > row_hovered->lastWindow->origin + row_hovered->lastWindow->size) {
         // cursor after last window
-        struct Edge* retval = malloc(sizeof(struct Edge));
-        retval->type = EDGE_WINDOW;
-        retval->row = row_hovered;
-        retval->window = row_hovered->lastWindow;
-        return retval;
+        return (struct Edge){EDGE_WINDOW, row_hovered, row_hovered->lastWindow};
     }
 
+    // the nearest window edge is either the first one after latPos or the one before it
+    size_t const i_after = findWindowEndingAfter(row_hovered, latPos + grid_windowSpacing / 2);
     double distToWindowEdge = fabs(grid_windowSpacing - latPos);  // first edge
     struct Window *window_nearestRightEdge = NULL;
-    for (struct Window *window = row_hovered->firstWindow; window != NULL; window = window->next) {
+    if (i_after > 0) {
+        window_nearestRightEdge = row_hovered->windowIndex[i_after - 1];
+        double const winPos = window_nearestRightEdge->origin + window_nearestRightEdge->size - grid_windowSpacing / 2;
+        distToWindowEdge = fabs(winPos - latPos);
+    }
+    if (i_after < row_hovered->windowCount) {
+        struct Window* const window = row_hovered->windowIndex[i_after];
         double const winPos = window->origin + window->size - grid_windowSpacing / 2;
-        double const distToWindowEdge_current = fabs(winPos - latPos);
-        if (distToWindowEdge_current >= distToWindowEdge) {
-            // we've gone too far
-            break;
+        if (fabs(winPos - latPos) < distToWindowEdge) {
+            distToWindowEdge = fabs(winPos - latPos);
+            window_nearestRightEdge = window;
         }
-        distToWindowEdge = distToWindowEdge_current;
-        window_nearestRightEdge = window;
     }
 
-    struct Edge* retval = malloc(sizeof(struct Edge));
     if (distToRowEdge > distToWindowEdge) {
-        retval->type = EDGE_WINDOW;
-        retval->row = row_hovered;
-        retval->window = window_nearestRightEdge;
+        return (struct Edge){EDGE_WINDOW, row_hovered, window_nearestRightEdge};
     } else {
-        retval->type = EDGE_ROW;
-        retval->row = row_nearestBtmEdge;
-        retval->window = NULL;
+        return (struct Edge){EDGE_ROW, row_nearestBtmEdge, NULL};
     }
-
-    return retval;
 }
 
-// free after use
-struct Edge* getExactEdge(const struct Grid* grid) {
+struct Edge getExactEdge(const struct Grid* grid) {
     double longPos, latPos;
     getPointerPositionWithScroll(grid, &longPos, &latPos);
 
     struct Row* row_hovered = getHoveredRow(grid);
     if (row_hovered == NULL) {
-        return NULL;
+        return NO_EDGE;
     }
 
-    uint32_t const rowBtmEdge = row_hovered->origin + row_hovered->size;
+    int64_t const rowBtmEdge = getRowOrigin(row_hovered) + row_hovered->size;
     if (longPos < rowBtmEdge) {
         // inside of row hovered
-        for (struct Window* window = row_hovered->firstWindow; window != NULL; window = window->next) {
+        size_t const i = findWindowEndingAfter(row_hovered, latPos - grid_windowSpacing);
+        if (i < row_hovered->windowCount) {
+            struct Window* const window = row_hovered->windowIndex[i];
             uint32_t windowRightEdge = window->origin + window->size;
-            uint32_t windowRightEdgeEnd = windowRightEdge + grid_windowSpacing;
             if (latPos < windowRightEdge) {
                 // inside of window hovered
-                return NULL;
-            } else if (latPos < windowRightEdgeEnd) {
+                return NO_EDGE;
+            } else {
                 // window edge hovered
-                struct Edge* edge = malloc(sizeof(struct Edge));
-                edge->type = EDGE_WINDOW;
-                edge->row = row_hovered;
-                edge->window = window;
-                return edge;
+                return (struct Edge){EDGE_WINDOW, row_hovered, window};
             }
         }
         // pointer is placed after last window
-        struct Edge* edge = malloc(sizeof(struct Edge));
-        edge->type = EDGE_WINDOW;
-        edge->row = row_hovered;
-        edge->window = row_hovered->lastWindow;
-        return edge;
+        return (struct Edge){EDGE_WINDOW, row_hovered, row_hovered->lastWindow};
 
     } else {
         // top edge hovered
-        struct Edge* edge = malloc(sizeof(struct Edge));
-        edge->type = EDGE_ROW;
-        edge->row = row_hovered;
-        edge->window = NULL;
-        return edge;
+        return (struct Edge){EDGE_ROW, row_hovered, NULL};
     }
 }
 
@@ -1024,36 +1545,198 @@ void moveViewToEdge(wlc_handle const view, struct Edge *edge) {
             addWindowToRowAfter(window, edge->row, edge->window);
             break;
         }
+        case EDGE_NONE:
         case EDGE_CORNER: assert (false);
     }
 }
 
-// output management
+// shadow layout
+
+// What a drop changes. The simulation reads the rest of the grid as it is, so only these rows are copied.
+struct Drop {
+    const struct Window* window;
+    const struct Row* sourceRow;      // loses window
+    bool sourceEmptied;               // sourceRow is removed, as window is its only window
+    const struct Row* targetRow;      // gains window, NULL if window gets a row of its own
+    const struct Window* targetPrev;  // window is placed after this one in targetRow (NULL places it first)
+    const struct Row* newRowPrev;     // window's own row is placed after this one (NULL places it first)
+    uint32_t newRowSize;
+};
 
-void evacuateOutput(wlc_handle const output) {
-    struct Grid* grid = getGrid(output);
-    if (grid == NULL) {
+static struct ShadowWindow* addShadowWindow(struct ShadowLayout* const shadow, wlc_handle const view) {
+    if (shadow->windowCount == shadow->capacity) {
+        shadow->capacity = shadow->capacity == 0 ? 16 : shadow->capacity * 2;
+        shadow->windows = realloc(shadow->windows, shadow->capacity * sizeof(struct ShadowWindow));
+    }
+    struct ShadowWindow* const shadowWindow = &shadow->windows[shadow->windowCount++];
+    shadowWindow->view = view;
+    return shadowWindow;
+}
+
+// the moved window's preferred size goes into rowWeights like the others' (see addWindowToRowAfter)
+static void gatherShadowWindow(struct ShadowLayout* const shadow, const struct Window* const window,
+                               size_t* const count, uint64_t* const sum) {
+    uint32_t const preferredSize = orientation->getWindowPreferredSize(window);
+    rowWeights[(*count)++] = preferredSize;
+    *sum += preferredSize;
+    addShadowWindow(shadow, window->view);
+}
+
+// adds the windows of a row on screen to shadow, row is NULL for window's own new row
+static void simulateRowAt(struct ShadowLayout* const shadow, const struct Drop* const drop, const struct Row* const row,
+                          uint32_t const rowSize, int32_t const screenOrigin) {
+    if (row != NULL && row != drop->sourceRow && row != drop->targetRow) {
+        // unchanged by the drop
+        for (const struct Window* window = row->firstWindow; window != NULL; window = window->next) {
+            addShadowWindow(shadow, window->view)->geometry =
+                orientation->getWindowGeometry(screenOrigin, rowSize, window->origin, window->size);
+        }
         return;
     }
 
-    // find target grid
-    struct Output* targetOutput = getAnOutput();
+    // the row's windows after the drop, resized like resizeWindowsIfNecessary would
+    size_t const first = shadow->windowCount;
+    size_t count = 0;
+    uint64_t sum = 0;
+    ensureRowScratchCapacity((row != NULL ? row->windowCount : 0) + 1);  // at most the moved window joins
+    if (row == NULL || (row == drop->targetRow && drop->targetPrev == NULL)) {
+        gatherShadowWindow(shadow, drop->window, &count, &sum);
+    }
+    if (row != NULL) {
+        for (const struct Window* window = row->firstWindow; window != NULL; window = window->next) {
+            if (window != drop->window) {
+                gatherShadowWindow(shadow, window, &count, &sum);
+            }
+            if (row == drop->targetRow && window == drop->targetPrev) {
+                gatherShadowWindow(shadow, drop->window, &count, &sum);
+            }
+        }
+    }
+    const uint32_t* const sizes = computeRowSizes(count, sum, drop->sourceRow->parent->output);
+    uint32_t origin = grid_windowSpacing;
+    for (size_t i = 0; i < count; i++) {
+        shadow->windows[first + i].geometry = orientation->getWindowGeometry(screenOrigin, rowSize, origin, sizes[i]);
+        origin += sizes[i] + grid_windowSpacing;
+    }
+}
+
+// Computes the windows on screen after moveViewToEdge(view, edge), without touching the grid or any view.
+// Like applyGridGeometryFrom, the cost depends on the number of visible rows, not on the size of the grid.
+void simulateMoveViewToEdge(wlc_handle const view, const struct Edge* const edge, struct ShadowLayout* const shadow) {
+    const struct Window* const window = getWindow(view);
+    assert (window != NULL);  // only gridded windows can be moved
+    assert (!doesEdgeBelongToView(edge, view));
+    const struct Grid* const grid = window->parent->parent;
+    shadow->output = grid->output;
+    shadow->windowCount = 0;
+
+    struct Drop drop = {
+        .window = window,
+        .sourceRow = window->parent,
+        .sourceEmptied = window->prev == NULL && window->next == NULL,
+        .targetRow = NULL,
+        .targetPrev = NULL,
+        .newRowPrev = NULL,
+        .newRowSize = 0,
+    };
+    switch (edge->type) {
+        case EDGE_ROW: {
+            // the row takes the size the view is reset to, see createRowAndPlaceAfter
+            drop.newRowPrev = edge->row;
+            drop.newRowSize = orientation->getLongSize((struct GridSize){window->preferredWidth, window->preferredHeight});
+            break;
+        }
+        case EDGE_WINDOW: {
+            drop.targetRow = edge->row;
+            drop.targetPrev = edge->window;
+            break;
+        }
+        case EDGE_NONE:
+        case EDGE_CORNER: assert (false);
+    }
+    bool const newRow = drop.targetRow == NULL;
+    int64_t const sourceLength = (int64_t)drop.sourceRow->size + grid_windowSpacing;
+    int64_t const newRowLength = newRow ? (int64_t)drop.newRowSize + grid_windowSpacing : 0;
 
-    if (targetOutput == NULL) {
+    // removing the source row clamps the scroll, see removeRow
+    double scroll = grid->scroll;
+    if (drop.sourceEmptied) {
+        int64_t const overflow = rowIndexGetLength(grid) - sourceLength - getPageLength(grid->output);
+        if (scroll > overflow) {
+            scroll = overflow < 0 ? 0.0 : overflow;
+        }
+    }
+    int64_t const offset = llround(scroll);
+    uint32_t const pageLength = getPageLength(grid->output);
+
+    // rows after the source row move back, rows after the new row move forward,
+    // so the first row on screen after the drop is at most newRowLength before the first one now
+    const struct Row* row = rowIndexFindEndingAfter(grid, offset - newRowLength - 1);
+    const struct Row* const prev = row == NULL ? grid->lastRow : row->prev;
+    bool newRowPending = newRow && drop.newRowPrev == prev;
+    int64_t origin;  // where the next row starts after the drop
+    if (row == NULL) {
+        if (!newRowPending) {
+            return;
+        }
+        origin = rowIndexGetLength(grid) - (drop.sourceEmptied ? sourceLength : 0) + grid_windowSpacing;
+    } else {
+        // if the new row comes right before row, origin is where the new row starts
+        size_t const position = rowIndexGetPosition(row);
+        origin = getRowOrigin(row);
+        if (drop.sourceEmptied && rowIndexGetPosition(drop.sourceRow) < position) {
+            origin -= sourceLength;
+        }
+        if (newRow && !newRowPending && (drop.newRowPrev == NULL || rowIndexGetPosition(drop.newRowPrev) < position)) {
+            origin += newRowLength;
+        }
+    }
+
+    while (true) {
+        const struct Row* current;
+        uint32_t size;
+        if (newRowPending) {
+            current = NULL;
+            size = drop.newRowSize;
+            newRowPending = false;
+        } else if (row != NULL) {
+            current = row;
+            size = row->size;
+            row = row->next;
+            newRowPending = newRow && drop.newRowPrev == current;
+            if (current == drop.sourceRow && drop.sourceEmptied) {
+                continue;
+            }
+        } else {
+            break;
+        }
+
+        int64_t const screenOrigin = origin - offset;
+        if (screenOrigin > pageLength) {
+            break;
+        }
+        if (isRowOnScreen(screenOrigin, size, pageLength)) {
+            simulateRowAt(shadow, &drop, current, size, rebaseToScreen(screenOrigin));
+        }
+        origin += size + grid_windowSpacing;
+    }
+}
+
+void freeShadowLayout(struct ShadowLayout* const shadow) {
+    free(shadow->windows);
+    *shadow = EMPTY_SHADOW_LAYOUT;
+}
+
+// output management
+
+void evacuateGrid(struct Grid* const grid, struct Grid* const targetGrid) {
+    if (targetGrid == NULL) {
         // we can't evacuate anywhere, close all windows
         clearGrid(grid);
     } else {
-        assert (targetOutput->grid != NULL);  // all outputs have grids
-        struct Grid* targetGrid = targetOutput->grid;
         // move all rows to targetGrid
-        while (grid->firstRow != NULL) {
-            struct Row* firstRow = grid->firstRow;
-            removeRow(firstRow);
-            addRowToGrid(firstRow, targetGrid);
-        }
+        spliceGrid(grid, targetGrid);
     }
-
-    destroyGrid(output);
 }
 
 bool ensureMinSize(uint32_t* size) {
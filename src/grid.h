@@ -1,14 +1,36 @@
 #pragma once
 
-#include <wlc/wlc.h>
+#include "gridbackend.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 
 #define MIN_WINDOW_SIZE 64
 
+// set by the config before grid_init
+extern bool grid_horizontal;
+extern bool grid_minimizeEmptySpace;
+extern uint32_t grid_windowSpacing;
+
+struct History;      // see history.h
+struct RowSnapshot;
+
 struct Grid {
     struct Row* firstRow;
     struct Row* lastRow;
+    struct Row* rowIndexRoot;   // see rowindex.h
+    struct Row* firstShownRow;  // rows from firstShownRow to lastShownRow were visible when geometry was last applied
+    struct Row* lastShownRow;
+    uint32_t shownStamp;
+    int64_t appliedOffset;      // scroll offset of the geometry last applied
+    bool layoutDirty;           // geometry needs to be applied by flushGridLayout
+    struct Row* dirtyFrom;      // rows at or after this one moved since the last flush
+    struct Row* firstDirtyRow;  // rows whose windows changed since the last flush
     wlc_handle output;
-    double scroll;
+    uint64_t changeCount;       // incremented by every change of the rows and windows, see history.h
+    struct History* history;    // NULL until something is recorded
+    double scroll;              // viewport origin in the grid's 64-bit coordinates, see applyGridGeometryFrom
 };
 
 struct Row {
@@ -17,8 +39,22 @@ struct Row {
     struct Window* firstWindow;
     struct Window* lastWindow;
     struct Grid* parent;
-    int32_t origin;
     uint32_t size;
+    uint32_t shownStamp;        // equals parent->shownStamp if row was visible when geometry was last applied
+    struct Window** windowIndex;  // windows in order, rebuilt by layoutRow
+    size_t windowCount;         // kept up to date as windows are added and removed, unlike windowIndex
+    size_t windowIndexCapacity;
+    bool geometryDirty;         // windows changed since the last flush
+    struct Row* nextDirtyRow;
+    struct RowSnapshot* snapshot;  // the row as last captured by the history, NULL if it changed since
+
+    // row index (see rowindex.h)
+    struct Row* indexParent;
+    struct Row* indexLeft;
+    struct Row* indexRight;
+    uint32_t indexPriority;
+    size_t indexCount;
+    int64_t indexLength;
 };
 
 struct Window {
@@ -30,9 +66,16 @@ struct Window {
     uint32_t size;
     uint32_t preferredWidth;
     uint32_t preferredHeight;
+
+    // last values sent to the backend
+    struct GridGeometry appliedGeometry;
+    uint32_t appliedMask;
+    bool appliedGeometryValid;
+    bool appliedMaskValid;
 };
 
 enum EdgeType {
+    EDGE_NONE,
     EDGE_ROW,
     EDGE_WINDOW,
     EDGE_CORNER
@@ -44,12 +87,48 @@ struct Edge {
     struct Window* window;  // window before edge
 };
 
-void grid_init();
+#define NO_EDGE ((struct Edge){EDGE_NONE, NULL, NULL})
+
+// the arrangement a drop would produce, see simulateMoveViewToEdge
+struct ShadowWindow {
+    wlc_handle view;
+    struct GridGeometry geometry;  // on screen
+};
+
+struct ShadowLayout {
+    wlc_handle output;
+    struct ShadowWindow* windows;  // the windows on screen after the drop
+    size_t windowCount;
+    size_t capacity;
+};
+
+#define EMPTY_SHADOW_LAYOUT ((struct ShadowLayout){0, NULL, 0, 0})
+
+// where createWindowAt places a window, used to restore a saved layout (see session.h)
+struct WindowPlacement {
+    struct Window* neighbor;  // NULL places the window in a new last row, like createWindow
+    bool before;              // place the window before neighbor rather than after it
+    bool sameRow;             // join neighbor's row rather than getting a new row next to it
+    uint32_t rowSize;         // size of a new row, 0 takes it from the view
+    uint32_t preferredWidth;
+    uint32_t preferredHeight;
+};
+
+// counts of geometry and mask updates sent, and of the ones skipped because nothing changed
+extern struct GeometryStats {
+    uint64_t geometriesSent;
+    uint64_t geometriesSuppressed;
+    uint64_t masksSent;
+    uint64_t masksSuppressed;
+} geometryStats;
+
+void grid_init(const struct GridBackend* backend);
+void grid_free();
 
 // getters
+const struct GridBackend* getGridBackend();
 struct Grid* getGrid(wlc_handle output);
 struct Window* getWindow(wlc_handle view);
-bool isGriddable(wlc_handle view);
 bool isGridded(wlc_handle view);
 bool isFloating(wlc_handle view);
 uint32_t getMaxRowLength(wlc_handle output);
@@ -57,29 +136,46 @@ uint32_t getPageLength(wlc_handle output);
 
 // grid operations
 struct Grid* createGrid(wlc_handle output);
-void destroyGrid(wlc_handle output);
-static void layoutGrid(struct Grid* grid);
-void layoutGridAt(struct Row* row);
-static void applyGridGeometry(struct Grid* grid);
+void destroyGrid(struct Grid* grid);  // grid must be evacuated first
+static void applyGridGeometryFrom(struct Grid* grid, const struct Row* row);
+static void scheduleGridLayout(struct Grid* grid);
+static void invalidateEdges(bool windowsFreed);
+static void invalidateGridFrom(struct Grid* grid, struct Row* from);
+void flushGridLayout(struct Grid* grid);  // applies geometry changed since the last flush, called once per frame
+static void emptyGrid(struct Grid* grid);
 static void clearGrid(struct Grid* grid);
+static void spliceGrid(struct Grid* grid, struct Grid* targetGrid);
+void rebuildGrid(struct Grid* grid, struct Window* const* windows, const size_t* rowWindowCounts,
+                 const uint32_t* rowSizes, size_t rowCount, double scroll);
 
 // row operations
 static struct Row* createRow(wlc_handle view);  // creates a new Row to house the given view
 static struct Row* createRowAndPlaceAfter(wlc_handle view, struct Row* prev);
+static struct Row* allocRow(uint32_t size);
+static void freeRow(struct Row* row);
+static void rowChanged(struct Row* row);
 bool isLastRow(const struct Row* row);
-bool isRowEdge(enum wlc_resize_edge edge);
 static void addRowToGrid(struct Row* row, struct Grid* grid);
 static void addRowToGridAfter(struct Row* row, struct Grid* grid, struct Row* prev);
 static void removeRow(struct Row* row);
+static void linkRowAfter(struct Row* row, struct Grid* grid, struct Row* prev);
+static void unlinkRow(struct Row* row);
+static void ensureRowScratchCapacity(size_t windowCount);
 static void resizeWindowsIfNecessary(struct Row* row);
 void layoutRow(struct Row* row);
-static void positionRow(struct Row* row);
+static void indexRowWindows(struct Row* row, size_t windowCount);
+static size_t findWindowEndingAfter(const struct Row* row, double latPos);  // returns windowCount if there is none
+int64_t getRowOrigin(const struct Row* row);
+static void invalidateRow(struct Row* row);
 static void applyRowGeometry(const struct Row* row);
+static void hideRow(const struct Row* row);
 static void scrollToRow(const struct Row* row);
 void resizeRow(struct Row* row, int32_t sizeDelta);
 
 // window operations
-struct Window* createWindow(wlc_handle view);
+struct Window* createWindow(wlc_handle view);  // the caller decides whether view should be gridded
+struct Window* createWindowAt(wlc_handle view, const struct WindowPlacement* placement);  // neighbor must be on view's output
+static struct Window* allocWindow(wlc_handle view, uint32_t preferredWidth, uint32_t preferredHeight);
 void destroyWindow(wlc_handle view);
 bool isLastWindow(const struct Window* window);
 bool viewResized(wlc_handle view);  // returns true if resizing handled by grid
@@ -87,26 +183,30 @@ static void addWindowToRow(struct Window* window, struct Row* row);
 static void addWindowToRowAfter(struct Window* window, struct Row* row, struct Window* prev);
 static void removeWindow(struct Window* window);
 static void positionWindow(struct Window* window);
-static void applyWindowGeometry(const struct Window* window);
+static void setWindowMask(struct Window* window, uint32_t mask);
+static void setWindowGeometry(struct Window* window, const struct GridGeometry* geometry);
 uint32_t getWindowPreferredSize(const struct Window* window);
 void resizeWindow(struct Window* window, int32_t sizeDelta);
 static void resetWindowSize(struct Window* window);
 
 // presentation
 void printGrid(const struct Grid* grid);
+void printGeometryStats();
 void scrollGrid(struct Grid* grid, double amount);
+static void applyScroll(struct Grid* grid);
 static void ensureSensibleScroll(struct Grid* grid);
 
 // neighboring Windows
+static struct Window* getWindowNearest(const struct Row* row, double latPos);
 static struct Window* getWindowParallelPrev(const struct Window* window);
 static struct Window* getWindowParallelNext(const struct Window* window);
-static struct Window* getWindowAbove(const struct Window* window);
-static struct Window* getWindowBelow(const struct Window* window);
-static struct Window* getWindowLeft(const struct Window* window);
-static struct Window* getWindowRight(const struct Window* window);
+static struct Window* getWindowPrev(const struct Window* window);
+static struct Window* getWindowNext(const struct Window* window);
 
 // view management
+static void focusSelectedRow(const struct Row* selectedRow, wlc_handle currentView);
 void focusRow(size_t index, wlc_handle currentView);
+void focusRowRelative(int32_t delta, wlc_handle currentView);  // clamped to the first and last row
 void focusViewAbove(wlc_handle view);
 void focusViewBelow(wlc_handle view);
 void focusViewLeft(wlc_handle view);
@@ -115,21 +215,26 @@ void moveViewUp(wlc_handle view);
 void moveViewDown(wlc_handle view);
 void moveViewLeft(wlc_handle view);
 void moveViewRight(wlc_handle view);
+static void swapRows(struct Row* first, struct Row* second);
+static void moveRow(struct Row* row, int32_t delta);
+void moveRowBy(wlc_handle view, int32_t delta);
 void moveRowBack(wlc_handle view);
 void moveRowForward(wlc_handle view);
 void scrollToView(wlc_handle view);
 void getPointerPositionWithScroll(const struct Grid* grid, double* longPos, double* latPos);
-enum wlc_resize_edge getNearestEdgeOfView(wlc_handle view);
-enum wlc_resize_edge getNearestCornerOfView(wlc_handle view);
 struct Row* getHoveredRow(const struct Grid* grid);    // bottom edge is considered part of row
                                                        // returns last row if pointer is below last row
-struct Edge* getNearestEdge(const struct Grid* grid);  // free after use
-struct Edge* getExactEdge(const struct Grid* grid);    // free after use
+struct Edge getNearestEdge(const struct Grid* grid);  // returns NO_EDGE if there is none
+struct Edge getExactEdge(const struct Grid* grid);    // returns NO_EDGE if there is none
 bool doesEdgeBelongToView(const struct Edge* edge, wlc_handle view);
 void moveViewToEdge(wlc_handle view, struct Edge *edge);
 
+// shadow layout
+void simulateMoveViewToEdge(wlc_handle view, const struct Edge* edge, struct ShadowLayout* shadow);  // doesn't touch the grid or any view
+void freeShadowLayout(struct ShadowLayout* shadow);
+
 // output management
-void evacuateOutput(wlc_handle output);
+void evacuateGrid(struct Grid* grid, struct Grid* targetGrid);  // moves all rows to targetGrid, closes them if it's NULL
 
 // misc
 bool ensureMinSize(uint32_t* size);  // returns true if size was too small
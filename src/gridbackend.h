@@ -0,0 +1,55 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// The grid doesn't call wlc itself, everything it needs from the compositor goes through a GridBackend.
+// endlesswm passes the wlc backend (see wlcbackend.h), benchmarks and tools pass a headless one.
+
+// same definition as in wlc/defines.h, so handles pass between the grid and wlc unchanged
+typedef uintptr_t wlc_handle;
+
+struct GridPoint {
+    int32_t x;
+    int32_t y;
+};
+
+struct GridSize {
+    uint32_t w;
+    uint32_t h;
+};
+
+struct GridGeometry {
+    struct GridPoint origin;
+    struct GridSize size;
+};
+
+struct Grid;
+struct Window;
+
+struct GridBackend {
+    // metadata kept by the compositor
+    struct Grid* (*getGrid)(wlc_handle output);
+    struct Window* (*getWindow)(wlc_handle view);
+    void (*forgetWindow)(wlc_handle view);  // the grid freed the view's Window without destroyWindow
+
+    // views
+    wlc_handle (*getViewParent)(wlc_handle view);
+    wlc_handle (*getViewOutput)(wlc_handle view);
+    struct GridGeometry (*getViewGeometry)(wlc_handle view);
+    struct GridGeometry (*getViewVisibleGeometry)(wlc_handle view);  // what's drawn, lags behind until the client resizes
+    void (*setViewGeometry)(wlc_handle view, const struct GridGeometry* geometry);
+    void (*setViewMask)(wlc_handle view, uint32_t mask);
+    void (*setViewOutput)(wlc_handle view, wlc_handle output);
+    void (*focusView)(wlc_handle view);
+    void (*closeView)(wlc_handle view);
+
+    // outputs
+    struct GridSize (*getOutputSize)(wlc_handle output);
+    wlc_handle (*getFocusedOutput)();
+    void (*scheduleRender)(wlc_handle output);
+
+    // pointer
+    void (*getPointerPosition)(double* x, double* y);
+    void (*edgesInvalidated)(bool windowsFreed);  // Edges held outside of the grid may refer to moved or freed rows
+};
@@ -0,0 +1,45 @@
+#include "gridcommand.h"
+#include "gridbackend.h"
+#include "history.h"
+
+#include <assert.h>
+
+// commands that change the layout record it before and after, so that they can be undone
+static void runMoveCommand(enum GridCommand const command, wlc_handle const view, int32_t const count) {
+    const struct Window* const window = getWindow(view);
+    assert (window != NULL);  // only gridded views are moved
+    struct Grid* const grid = window->parent->parent;
+
+    recordGridChange(grid);
+    switch (command) {
+        case GRID_COMMAND_MOVE_ROW: moveRowBy(view, count); break;
+        case GRID_COMMAND_MOVE_WINDOW_UP: moveViewUp(view); break;
+        case GRID_COMMAND_MOVE_WINDOW_DOWN: moveViewDown(view); break;
+        case GRID_COMMAND_MOVE_WINDOW_LEFT: moveViewLeft(view); break;
+        case GRID_COMMAND_MOVE_WINDOW_RIGHT: moveViewRight(view); break;
+        default: break;
+    }
+    recordGridChange(grid);
+}
+
+void runGridCommand(enum GridCommand const command, wlc_handle const view, int32_t const count) {
+    switch (command) {
+        case GRID_COMMAND_FOCUS_WINDOW_UP: focusViewAbove(view); break;
+        case GRID_COMMAND_FOCUS_WINDOW_DOWN: focusViewBelow(view); break;
+        case GRID_COMMAND_FOCUS_WINDOW_LEFT: focusViewLeft(view); break;
+        case GRID_COMMAND_FOCUS_WINDOW_RIGHT: focusViewRight(view); break;
+        case GRID_COMMAND_MOVE_ROW:
+        case GRID_COMMAND_MOVE_WINDOW_UP:
+        case GRID_COMMAND_MOVE_WINDOW_DOWN:
+        case GRID_COMMAND_MOVE_WINDOW_LEFT:
+        case GRID_COMMAND_MOVE_WINDOW_RIGHT: {
+            runMoveCommand(command, view, count);
+            break;
+        }
+        case GRID_COMMAND_FOCUS_ROW: focusRow((size_t)count, view); break;
+        case GRID_COMMAND_FOCUS_ROW_RELATIVE: focusRowRelative(count, view); break;
+        case GRID_COMMAND_UNDO: undoGridChange(getGrid(getGridBackend()->getFocusedOutput())); break;
+        case GRID_COMMAND_REDO: redoGridChange(getGrid(getGridBackend()->getFocusedOutput())); break;
+        default: break;
+    }
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include "grid.h"
+
+// The grid commands bound to keys. keyboard.c runs them and trace.c records which one ran, so that
+// grid_replay can run the same command without knowing the keybindings of the recorded session.
+
+enum GridCommand {
+    GRID_COMMAND_FOCUS_WINDOW_UP,
+    GRID_COMMAND_FOCUS_WINDOW_DOWN,
+    GRID_COMMAND_FOCUS_WINDOW_LEFT,
+    GRID_COMMAND_FOCUS_WINDOW_RIGHT,
+    GRID_COMMAND_MOVE_ROW,           // by count rows
+    GRID_COMMAND_MOVE_WINDOW_UP,
+    GRID_COMMAND_MOVE_WINDOW_DOWN,
+    GRID_COMMAND_MOVE_WINDOW_LEFT,
+    GRID_COMMAND_MOVE_WINDOW_RIGHT,
+    GRID_COMMAND_FOCUS_ROW,          // the row at index count
+    GRID_COMMAND_FOCUS_ROW_RELATIVE, // count rows from the current one
+    GRID_COMMAND_UNDO,               // on the focused output
+    GRID_COMMAND_REDO,
+    GRID_COMMAND_COUNT
+};
+
+// commands on windows need a gridded view, the others take the focused view or 0
+void runGridCommand(enum GridCommand command, wlc_handle view, int32_t count);
@@ -0,0 +1,178 @@
+#include "griddrag.h"
+#include "gridbackend.h"
+#include "history.h"
+
+#include <assert.h>
+#include <math.h>
+
+enum GridDragState gridDragState = GRID_DRAG_NONE;
+struct Edge hoveredEdge = NO_EDGE;
+struct Edge insertEdge = NO_EDGE;
+
+static wlc_handle movedView = 0;
+static struct Window* resizedWindow = NULL;
+static struct Row* resizedRow = NULL;
+static struct Grid* draggedGrid = NULL;  // grid changed by the current drag, recorded when it ends
+static struct ShadowLayout dropShadow = EMPTY_SHADOW_LAYOUT;
+static bool dropShadowValid = false;  // dropShadow simulates dropping movedView at insertEdge
+
+static void beginDrag(enum GridDragState const state, struct Grid* const grid) {
+    gridDragState = state;
+    draggedGrid = grid;
+    recordGridChange(grid);
+}
+
+void beginGridMove(wlc_handle const view) {
+    const struct Window* const window = getWindow(view);
+    assert (window != NULL);  // only gridded views are moved here
+    movedView = view;
+    insertEdge = NO_EDGE;
+    dropShadowValid = false;
+    beginDrag(GRID_DRAG_MOVE, window->parent->parent);
+}
+
+enum ViewSide {
+    SIDE_TOP,
+    SIDE_BOTTOM,
+    SIDE_LEFT,
+    SIDE_RIGHT
+};
+
+static enum ViewSide getNearestSideOfView(wlc_handle const view) {
+    const struct GridBackend* const backend = getGridBackend();
+    double x, y;
+    backend->getPointerPosition(&x, &y);
+    struct GridGeometry const geom = backend->getViewGeometry(view);
+    double const distToTop = y - geom.origin.y;
+    double const distToBtm = geom.origin.y + geom.size.h - y;
+    double const distToLeft = x - geom.origin.x;
+    double const distToRight = geom.origin.x + geom.size.w - x;
+
+    double const distToHorizontal = distToTop < distToBtm ? distToTop : distToBtm;
+    if (distToHorizontal < distToLeft && distToHorizontal < distToRight) {
+        return distToTop < distToBtm ? SIDE_TOP : SIDE_BOTTOM;
+    }
+    return distToLeft < distToRight ? SIDE_LEFT : SIDE_RIGHT;
+}
+
+static bool beginRowResize(struct Row* const row) {
+    if (row == NULL) {
+        return false;
+    }
+    resizedRow = row;
+    beginDrag(GRID_DRAG_RESIZE_ROW, row->parent);
+    return true;
+}
+
+static bool beginWindowResize(struct Window* const window) {
+    if (window == NULL) {
+        return false;
+    }
+    resizedWindow = window;
+    beginDrag(GRID_DRAG_RESIZE_WINDOW, window->parent->parent);
+    return true;
+}
+
+bool beginGridResize(wlc_handle const view) {
+    if (view == 0) {
+        switch (hoveredEdge.type) {
+            case EDGE_ROW: return beginRowResize(hoveredEdge.row);
+            case EDGE_WINDOW: return beginWindowResize(hoveredEdge.window);
+            case EDGE_CORNER: // TODO
+            default: return false;
+        }
+    }
+
+    struct Window* const window = getWindow(view);
+    assert (window != NULL);  // only gridded views are resized here
+    enum ViewSide const side = getNearestSideOfView(view);
+    bool const previousEdge = side == SIDE_TOP || side == SIDE_LEFT;
+    bool const horizontalEdge = side == SIDE_TOP || side == SIDE_BOTTOM;
+    if (horizontalEdge != grid_horizontal) {
+        // the edge between two rows
+        return beginRowResize(previousEdge ? window->parent->prev : window->parent);
+    } else {
+        return beginWindowResize(previousEdge ? window->prev : window);
+    }
+}
+
+void endGridDrag() {
+    if (gridDragState == GRID_DRAG_MOVE && insertEdge.type != EDGE_NONE) {
+        moveViewToEdge(movedView, &insertEdge);
+    }
+    if (draggedGrid != NULL) {
+        recordGridChange(draggedGrid);
+    }
+    cancelGridDrag();
+}
+
+void cancelGridDrag() {
+    gridDragState = GRID_DRAG_NONE;
+    movedView = 0;
+    resizedWindow = NULL;
+    resizedRow = NULL;
+    draggedGrid = NULL;
+    insertEdge = NO_EDGE;
+    dropShadowValid = false;
+}
+
+wlc_handle getGridDragView() {
+    return movedView;
+}
+
+void gridPointerMotion(wlc_handle const view, double const dx, double const dy) {
+    insertEdge = NO_EDGE;
+    dropShadowValid = false;
+
+    const struct GridBackend* const backend = getGridBackend();
+    switch (gridDragState) {
+        case GRID_DRAG_NONE: {
+            hoveredEdge = view ? NO_EDGE : getExactEdge(getGrid(backend->getFocusedOutput()));
+            break;
+        }
+        case GRID_DRAG_MOVE: {
+            insertEdge = getNearestEdge(getGrid(backend->getFocusedOutput()));
+
+            // don't allow moving to the same position
+            if (doesEdgeBelongToView(&insertEdge, movedView)) {
+                insertEdge = NO_EDGE;
+            }
+            break;
+        }
+        case GRID_DRAG_RESIZE_ROW: {
+            resizeRow(resizedRow, (int32_t)round(grid_horizontal ? dx : dy));
+            break;
+        }
+        case GRID_DRAG_RESIZE_WINDOW: {
+            resizeWindow(resizedWindow, (int32_t)round(grid_horizontal ? dy : dx));
+            break;
+        }
+    }
+}
+
+void gridDragHandleEdgesInvalidated(bool const windowsFreed) {
+    hoveredEdge = NO_EDGE;
+    dropShadowValid = false;
+    if (windowsFreed) {
+        cancelGridDrag();
+    }
+}
+
+// the arrangement the grid would have if movedView was dropped now, NULL if it wouldn't move
+// simulated at most once per pointer motion or grid change, when it's painted
+const struct ShadowLayout* getDropShadow() {
+    if (gridDragState != GRID_DRAG_MOVE || insertEdge.type == EDGE_NONE) {
+        return NULL;
+    }
+    if (!dropShadowValid) {
+        simulateMoveViewToEdge(movedView, &insertEdge, &dropShadow);
+        dropShadowValid = true;
+    }
+    return &dropShadow;
+}
+
+void griddrag_free() {
+    cancelGridDrag();
+    hoveredEdge = NO_EDGE;
+    freeShadowLayout(&dropShadow);
+}
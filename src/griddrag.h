@@ -0,0 +1,28 @@
+#pragma once
+
+#include "grid.h"
+
+// The grid's side of the pointer: hovering edges, dragging gridded views to an edge and dragging edges to resize.
+// mouse.c drives it from wlc's callbacks, grid_replay drives it from a trace, so both run the same code.
+// Each drag is a single change in the history.
+
+extern enum GridDragState {
+    GRID_DRAG_NONE,
+    GRID_DRAG_MOVE,
+    GRID_DRAG_RESIZE_WINDOW,
+    GRID_DRAG_RESIZE_ROW
+} gridDragState;
+
+extern struct Edge hoveredEdge;  // edge under the pointer while not dragging
+extern struct Edge insertEdge;   // edge the moved view would be dropped at
+
+void beginGridMove(wlc_handle view);    // view must be gridded
+bool beginGridResize(wlc_handle view);  // the edge of view nearest to the pointer, or hoveredEdge if view is 0
+                                        // returns false if there's no such edge
+void endGridDrag();                     // drops the moved view at insertEdge
+void cancelGridDrag();                  // forgets the drag without dropping or recording it
+wlc_handle getGridDragView();           // the moved view, 0 if none
+void gridPointerMotion(wlc_handle view, double dx, double dy);  // view is the one under the pointer
+void gridDragHandleEdgesInvalidated(bool windowsFreed);
+const struct ShadowLayout* getDropShadow();  // NULL if the moved view wouldn't move
+void griddrag_free();
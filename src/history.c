@@ -0,0 +1,317 @@
+#include "history.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+// A chunk ends at a row whose snapshot says so, so chunk boundaries move with the rows instead of being fixed
+// positions. Moving, adding or removing a row only splits or merges the chunks around it, the rest are shared.
+#define CHUNK_TARGET_ROWS 32
+#define CHUNK_MAX_ROWS 128
+
+struct WindowSnapshot {
+    wlc_handle view;
+    uint32_t preferredWidth;
+    uint32_t preferredHeight;
+};
+
+struct RowSnapshot {
+    size_t refCount;              // chunks holding it, and the row it was captured from
+    struct ChunkSnapshot* chunk;  // the last chunk that started with this row, NULL once it's freed
+    bool endsChunk;
+    uint32_t size;
+    size_t windowCount;
+    struct WindowSnapshot windows[];
+};
+
+struct ChunkSnapshot {
+    size_t refCount;
+    size_t rowCount;
+    struct RowSnapshot* rows[];
+};
+
+struct GridSnapshot {
+    double scroll;
+    size_t chunkCount;
+    struct ChunkSnapshot* chunks[];
+};
+
+static uint32_t nextChunkRandom() {
+    // xorshift, boundaries only need to be well distributed
+    static uint32_t state = 2463534242;
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+// rows
+
+static struct RowSnapshot* captureRow(const struct Row* row) {
+    size_t windowCount = 0;
+    for (const struct Window* window = row->firstWindow; window != NULL; window = window->next) {
+        windowCount++;
+    }
+    struct RowSnapshot* snapshot = malloc(sizeof(struct RowSnapshot) + windowCount * sizeof(struct WindowSnapshot));
+    snapshot->refCount = 1;
+    snapshot->chunk = NULL;
+    snapshot->endsChunk = nextChunkRandom() % CHUNK_TARGET_ROWS == 0;
+    snapshot->size = row->size;
+    snapshot->windowCount = windowCount;
+    size_t i = 0;
+    for (const struct Window* window = row->firstWindow; window != NULL; window = window->next) {
+        snapshot->windows[i++] = (struct WindowSnapshot){window->view, window->preferredWidth, window->preferredHeight};
+    }
+    return snapshot;
+}
+
+void releaseRowSnapshot(struct RowSnapshot* snapshot) {
+    if (snapshot != NULL && --snapshot->refCount == 0) {
+        free(snapshot);
+    }
+}
+
+// chunks
+
+// reuses the chunk the first row last started if it holds the same rows
+static struct ChunkSnapshot* shareChunk(struct RowSnapshot* const* rows, size_t const rowCount) {
+    struct ChunkSnapshot* chunk = rows[0]->chunk;
+    if (chunk != NULL && chunk->rowCount == rowCount && memcmp(chunk->rows, rows, rowCount * sizeof(*rows)) == 0) {
+        chunk->refCount++;
+        return chunk;
+    }
+    chunk = malloc(sizeof(struct ChunkSnapshot) + rowCount * sizeof(struct RowSnapshot*));
+    chunk->refCount = 1;
+    chunk->rowCount = rowCount;
+    for (size_t i = 0; i < rowCount; i++) {
+        rows[i]->refCount++;
+        chunk->rows[i] = rows[i];
+    }
+    rows[0]->chunk = chunk;
+    return chunk;
+}
+
+static void releaseChunk(struct ChunkSnapshot* chunk) {
+    if (--chunk->refCount > 0) {
+        return;
+    }
+    if (chunk->rows[0]->chunk == chunk) {
+        chunk->rows[0]->chunk = NULL;
+    }
+    for (size_t i = 0; i < chunk->rowCount; i++) {
+        releaseRowSnapshot(chunk->rows[i]);
+    }
+    free(chunk);
+}
+
+// grids
+
+static void pushChunk(struct GridSnapshot** const snapshot, size_t* const capacity, struct ChunkSnapshot* const chunk) {
+    if ((*snapshot)->chunkCount == *capacity) {
+        *capacity *= 2;
+        *snapshot = realloc(*snapshot, sizeof(struct GridSnapshot) + *capacity * sizeof(struct ChunkSnapshot*));
+    }
+    (*snapshot)->chunks[(*snapshot)->chunkCount++] = chunk;
+}
+
+// rows that didn't change since they were last captured are shared, not copied
+static struct GridSnapshot* captureGrid(struct Grid* grid) {
+    size_t capacity = 16;
+    struct GridSnapshot* snapshot = malloc(sizeof(struct GridSnapshot) + capacity * sizeof(struct ChunkSnapshot*));
+    snapshot->scroll = grid->scroll;
+    snapshot->chunkCount = 0;
+
+    struct RowSnapshot* rows[CHUNK_MAX_ROWS];
+    size_t rowCount = 0;
+    for (struct Row* row = grid->firstRow; row != NULL; row = row->next) {
+        if (row->snapshot == NULL) {
+            row->snapshot = captureRow(row);
+        }
+        rows[rowCount++] = row->snapshot;
+        if (row->snapshot->endsChunk || rowCount == CHUNK_MAX_ROWS) {
+            pushChunk(&snapshot, &capacity, shareChunk(rows, rowCount));
+            rowCount = 0;
+        }
+    }
+    if (rowCount > 0) {
+        pushChunk(&snapshot, &capacity, shareChunk(rows, rowCount));
+    }
+    return snapshot;
+}
+
+static void freeGridSnapshot(struct GridSnapshot* snapshot) {
+    for (size_t i = 0; i < snapshot->chunkCount; i++) {
+        releaseChunk(snapshot->chunks[i]);
+    }
+    free(snapshot);
+}
+
+// restoring
+
+struct Arrangement {
+    struct Window** windows;
+    size_t windowCount;
+    size_t windowCapacity;
+    size_t* rowWindowCounts;
+    uint32_t* rowSizes;
+    struct RowSnapshot** rowSources;  // the snapshot a row reproduces exactly, NULL if it differs
+    size_t rowCount;
+    size_t rowCapacity;
+};
+
+static void addArrangedWindow(struct Arrangement* const arrangement, struct Window* const window) {
+    if (arrangement->windowCount == arrangement->windowCapacity) {
+        arrangement->windowCapacity = arrangement->windowCapacity == 0 ? 64 : arrangement->windowCapacity * 2;
+        arrangement->windows = realloc(arrangement->windows, arrangement->windowCapacity * sizeof(struct Window*));
+    }
+    arrangement->windows[arrangement->windowCount++] = window;
+    arrangement->rowWindowCounts[arrangement->rowCount - 1]++;
+}
+
+static void addArrangedRow(struct Arrangement* const arrangement, uint32_t const size) {
+    if (arrangement->rowCount == arrangement->rowCapacity) {
+        arrangement->rowCapacity = arrangement->rowCapacity == 0 ? 64 : arrangement->rowCapacity * 2;
+        arrangement->rowWindowCounts = realloc(arrangement->rowWindowCounts, arrangement->rowCapacity * sizeof(size_t));
+        arrangement->rowSizes = realloc(arrangement->rowSizes, arrangement->rowCapacity * sizeof(uint32_t));
+        arrangement->rowSources = realloc(arrangement->rowSources, arrangement->rowCapacity * sizeof(struct RowSnapshot*));
+    }
+    arrangement->rowWindowCounts[arrangement->rowCount] = 0;
+    arrangement->rowSizes[arrangement->rowCount] = size;
+    arrangement->rowSources[arrangement->rowCount] = NULL;
+    arrangement->rowCount++;
+}
+
+// drops the last row if none of its windows are left
+static void endArrangedRow(struct Arrangement* const arrangement) {
+    if (arrangement->rowWindowCounts[arrangement->rowCount - 1] == 0) {
+        arrangement->rowCount--;
+    }
+}
+
+// Windows are matched to the snapshot by their views. Views closed since the snapshot are skipped, views opened
+// since (or brought over from another output) keep their rows, after the restored ones.
+static void restoreGrid(struct Grid* grid, const struct GridSnapshot* snapshot) {
+    struct Arrangement arrangement = {NULL, 0, 0, NULL, NULL, NULL, 0, 0};
+
+    // windows placed from the snapshot are marked by clearing their parent, rebuildGrid links them again
+    struct Row* const firstOldRow = grid->firstRow;
+    for (size_t c = 0; c < snapshot->chunkCount; c++) {
+        const struct ChunkSnapshot* const chunk = snapshot->chunks[c];
+        for (size_t r = 0; r < chunk->rowCount; r++) {
+            struct RowSnapshot* const rowSnapshot = chunk->rows[r];
+            addArrangedRow(&arrangement, rowSnapshot->size);
+            for (size_t w = 0; w < rowSnapshot->windowCount; w++) {
+                const struct WindowSnapshot* const windowSnapshot = &rowSnapshot->windows[w];
+                struct Window* const window = getWindow(windowSnapshot->view);
+                if (window == NULL || window->parent == NULL || window->parent->parent != grid) {
+                    continue;
+                }
+                window->parent = NULL;
+                window->preferredWidth = windowSnapshot->preferredWidth;
+                window->preferredHeight = windowSnapshot->preferredHeight;
+                addArrangedWindow(&arrangement, window);
+            }
+            if (arrangement.rowWindowCounts[arrangement.rowCount - 1] == rowSnapshot->windowCount) {
+                arrangement.rowSources[arrangement.rowCount - 1] = rowSnapshot;
+            }
+            endArrangedRow(&arrangement);
+        }
+    }
+    for (const struct Row* row = firstOldRow; row != NULL; row = row->next) {
+        addArrangedRow(&arrangement, row->size);
+        for (struct Window* window = row->firstWindow; window != NULL; window = window->next) {
+            if (window->parent != NULL) {
+                addArrangedWindow(&arrangement, window);
+            }
+        }
+        endArrangedRow(&arrangement);
+    }
+
+    rebuildGrid(grid, arrangement.windows, arrangement.rowWindowCounts, arrangement.rowSizes, arrangement.rowCount,
+                snapshot->scroll);
+
+    // rows that reproduce their snapshot share it again, so the next capture doesn't copy them
+    size_t i = 0;
+    for (struct Row* row = grid->firstRow; row != NULL; row = row->next) {
+        struct RowSnapshot* const source = arrangement.rowSources[i++];
+        if (source != NULL) {
+            assert (row->snapshot == NULL);
+            source->refCount++;
+            row->snapshot = source;
+        }
+    }
+
+    free(arrangement.windows);
+    free(arrangement.rowWindowCounts);
+    free(arrangement.rowSizes);
+    free(arrangement.rowSources);
+}
+
+// history
+
+static struct History* getHistory(struct Grid* grid) {
+    if (grid->history == NULL) {
+        grid->history = malloc(sizeof(struct History));
+        grid->history->count = 0;
+        grid->history->current = 0;
+        grid->history->changeCount = 0;
+    }
+    return grid->history;
+}
+
+void recordGridChange(struct Grid* grid) {
+    struct History* const history = getHistory(grid);
+    if (history->count > 0 && history->changeCount == grid->changeCount) {
+        // unchanged since the current entry
+        return;
+    }
+
+    // a new change drops the entries that could have been redone
+    while (history->count > history->current + 1) {
+        freeGridSnapshot(history->entries[--history->count]);
+    }
+    if (history->count == HISTORY_MAX_ENTRIES) {
+        freeGridSnapshot(history->entries[0]);
+        memmove(history->entries, history->entries + 1, (HISTORY_MAX_ENTRIES - 1) * sizeof(struct GridSnapshot*));
+        history->count--;
+    }
+    history->entries[history->count++] = captureGrid(grid);
+    history->current = history->count - 1;
+    history->changeCount = grid->changeCount;
+}
+
+static void restoreEntry(struct Grid* grid, size_t const entry) {
+    struct History* const history = grid->history;
+    history->current = entry;
+    restoreGrid(grid, history->entries[entry]);
+    history->changeCount = grid->changeCount;
+}
+
+bool undoGridChange(struct Grid* grid) {
+    recordGridChange(grid);  // so that whatever changed since the current entry can be redone
+    struct History* const history = grid->history;
+    if (history->current == 0) {
+        return false;
+    }
+    restoreEntry(grid, history->current - 1);
+    return true;
+}
+
+bool redoGridChange(struct Grid* grid) {
+    struct History* const history = grid->history;
+    if (history == NULL || history->changeCount != grid->changeCount || history->current + 1 >= history->count) {
+        return false;
+    }
+    restoreEntry(grid, history->current + 1);
+    return true;
+}
+
+void freeHistory(struct History* history) {
+    if (history == NULL) {
+        return;
+    }
+    for (size_t i = 0; i < history->count; i++) {
+        freeGridSnapshot(history->entries[i]);
+    }
+    free(history);
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "grid.h"
+
+// Undo and redo of layout changes. Each grid keeps a list of snapshots of its rows and windows.
+// Snapshots share everything that didn't change between them: a row that wasn't touched keeps the RowSnapshot
+// it was last captured as, and runs of rows that weren't touched keep their chunk, so an entry costs memory
+// only for the rows that changed and one pointer per chunk of rows.
+
+#define HISTORY_MAX_ENTRIES 256
+
+struct RowSnapshot;
+struct GridSnapshot;
+
+struct History {
+    struct GridSnapshot* entries[HISTORY_MAX_ENTRIES];  // oldest first
+    size_t count;
+    size_t current;        // the entry the grid was last captured as or restored to
+    uint64_t changeCount;  // grid->changeCount at that time
+};
+
+// Call before and after a change the user should be able to undo, e.g. a keyboard command or a mouse drag.
+// Captures the grid as a new entry, unless it's unchanged since the current one.
+void recordGridChange(struct Grid* grid);
+
+bool undoGridChange(struct Grid* grid);  // returns false if there's nothing to undo
+bool redoGridChange(struct Grid* grid);  // returns false if there's nothing to redo, or the grid changed since
+void freeHistory(struct History* history);
+
+void releaseRowSnapshot(struct RowSnapshot* snapshot);  // NULL is ignored
@@ -1,11 +1,73 @@
 #include "keyboard.h"
-#include "grid.h"
+#include "gridcommand.h"
+#include "session.h"
+#include "trace.h"
 
 #include <time.h>
 #include <wayland-server.h>
 #include <wlc/wlc-wayland.h>
 #include <stdio.h>
 
+#define MAX_ROW_NUMBER 99999999
+
+// row number typed with main mod + digits, applied when a modifier is released
+static uint32_t rowNumber = 0;
+static bool rowNumberTyped = false;
+static int32_t rowNumberSign = 0;  // 0 for an absolute row, -1 or 1 for a row relative to the current one
+
+static void resetRowNumber() {
+    rowNumber = 0;
+    rowNumberTyped = false;
+    rowNumberSign = 0;
+}
+
+static bool isModifierSym(uint32_t const sym) {
+    return sym >= XKB_KEY_Shift_L && sym <= XKB_KEY_Hyper_R;
+}
+
+// returns true if key is part of a row number
+static bool typeRowNumber(uint32_t const mods, uint32_t const sym) {
+    if (mods != MOD_WM0) {
+        return false;
+    }
+    if (sym >= XKB_KEY_0 && sym <= XKB_KEY_9) {
+        if (rowNumber <= MAX_ROW_NUMBER) {
+            rowNumber = rowNumber * 10 + (sym - XKB_KEY_0);
+        }
+        rowNumberTyped = true;
+        return true;
+    }
+    if (!rowNumberTyped && (sym == XKB_KEY_minus || sym == XKB_KEY_equal)) {
+        rowNumberSign = sym == XKB_KEY_minus ? -1 : 1;
+        return true;
+    }
+    return false;
+}
+
+// a typed row number can also be used as a count for the next command
+static int32_t getRowNumberAsCount() {
+    return rowNumberTyped && rowNumber > 0 ? (int32_t)rowNumber : 1;
+}
+
+// the trace records which grid command a key ran, so that grid_replay can run it too
+static void runTracedGridCommand(enum GridCommand const command, wlc_handle const view, int32_t const count) {
+    uint64_t const start = traceStart();
+    runGridCommand(command, view, count);
+    traceGridCommand(command, view, count, start);
+}
+
+static void applyRowNumber(wlc_handle const view) {
+    if (rowNumberTyped) {
+        if (rowNumberSign == 0) {
+            // "0" is the 10th row, "1" is the 1st, "2" the 2nd, ...
+            runTracedGridCommand(GRID_COMMAND_FOCUS_ROW, view, rowNumber == 0 ? 9 : (int32_t)rowNumber - 1);
+        } else {
+            runTracedGridCommand(GRID_COMMAND_FOCUS_ROW_RELATIVE, view, rowNumberSign * (int32_t)rowNumber);
+        }
+    }
+    resetRowNumber();
+}
+
 bool testKeystroke(const struct Keystroke* const keystroke, uint32_t const mods, uint32_t const sym) {
     return keystroke->mods == mods && keystroke->sym == sym;
 }
@@ -34,50 +96,66 @@ bool keyboard_key(wlc_handle view, uint32_t time, const struct wlc_modifiers *mo
     uint32_t const sym = wlc_keyboard_get_keysym_for_key(key, NULL);
     uint32_t const mods = modifiers->mods;
     
+    if (state == WLC_KEY_STATE_RELEASED) {
+        if (isModifierSym(sym)) {
+            applyRowNumber(view);
+        }
+        return false;
+    }
+
     if (state == WLC_KEY_STATE_PRESSED) {
+        // win+number row switching, e.g. win+1+2 jumps to row 12 and win+minus+3 jumps 3 rows back
+        if (typeRowNumber(mods, sym)) {
+            return true;
+        }
+        int32_t const count = getRowNumberAsCount();  // e.g. win+3 followed by moveRowForward moves 3 rows
+        if (!isModifierSym(sym)) {
+            resetRowNumber();
+        }
+
         if (view) {
 
             // view-related keys
 
             if (isGridded(view)) {
                 if (testKeystroke(&keystroke_focusWindowUp, mods, sym)) {
-                    focusViewAbove(view);
+                    runTracedGridCommand(GRID_COMMAND_FOCUS_WINDOW_UP, view, 1);
                     return true;
 
                 } else if (testKeystroke(&keystroke_focusWindowDown, mods, sym)) {
-                    focusViewBelow(view);
+                    runTracedGridCommand(GRID_COMMAND_FOCUS_WINDOW_DOWN, view, 1);
                     return true;
 
                 } else if (testKeystroke(&keystroke_focusWindowLeft, mods, sym)) {
-                    focusViewLeft(view);
+                    runTracedGridCommand(GRID_COMMAND_FOCUS_WINDOW_LEFT, view, 1);
                     return true;
 
                 } else if (testKeystroke(&keystroke_focusWindowRight, mods, sym)) {
-                    focusViewRight(view);
+                    runTracedGridCommand(GRID_COMMAND_FOCUS_WINDOW_RIGHT, view, 1);
                     return true;
 
                 } else if (testKeystroke(&keystroke_moveRowBack, mods, sym)) {
-                    moveRowBack(view);
+                    runTracedGridCommand(GRID_COMMAND_MOVE_ROW, view, -count);
                     return true;
 
                 } else if (testKeystroke(&keystroke_moveRowForward, mods, sym)) {
-                    moveRowForward(view);
+                    runTracedGridCommand(GRID_COMMAND_MOVE_ROW, view, count);
                     return true;
 
                 } else if (testKeystroke(&keystroke_moveWindowUp, mods, sym)) {
-                    moveViewUp(view);
+                    runTracedGridCommand(GRID_COMMAND_MOVE_WINDOW_UP, view, 1);
                     return true;
 
                 } else if (testKeystroke(&keystroke_moveWindowDown, mods, sym)) {
-                    moveViewDown(view);
+                    runTracedGridCommand(GRID_COMMAND_MOVE_WINDOW_DOWN, view, 1);
                     return true;
 
                 } else if (testKeystroke(&keystroke_moveWindowLeft, mods, sym)) {
-                    moveViewLeft(view);
+                    runTracedGridCommand(GRID_COMMAND_MOVE_WINDOW_LEFT, view, 1);
                     return true;
 
                 } else if (testKeystroke(&keystroke_moveWindowRight, mods, sym)) {
-                    moveViewRight(view);
+                    runTracedGridCommand(GRID_COMMAND_MOVE_WINDOW_RIGHT, view, 1);
                     return true;
 
                 }
@@ -92,9 +170,18 @@ bool keyboard_key(wlc_handle view, uint32_t time, const struct wlc_modifiers *mo
         // global keys
 
         if (testKeystroke(&keystroke_terminate, mods, sym)) {
+            saveSession();
             wlc_terminate();
             return true;
 
+        } else if (testKeystroke(&keystroke_undo, mods, sym)) {
+            runTracedGridCommand(GRID_COMMAND_UNDO, view, 1);
+            return true;
+
+        } else if (testKeystroke(&keystroke_redo, mods, sym)) {
+            runTracedGridCommand(GRID_COMMAND_REDO, view, 1);
+            return true;
+
         } else {
             // Application shortcuts
             for (size_t i = 0; i < applicationShortcutCount; i++) {
@@ -105,12 +192,6 @@ bool keyboard_key(wlc_handle view, uint32_t time, const struct wlc_modifiers *mo
                 }
             }
         }
-
-        // win+number row switching
-        if (mods == MOD_WM0 && sym >= '0' && sym <= '9') {
-            focusRow((sym - '0' + 9) % 10, view);  // '0' is 9, '1' is 0, '2' is 1, ...
-            return true;
-        }
     }
 
     return false;
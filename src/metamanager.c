@@ -1,4 +1,8 @@
 #include "metamanager.h"
+#include "config.h"
+#include "pool.h"
+#include "session.h"
+#include "wallpaper.h"
 
 #include <stdlib.h>
 
@@ -8,8 +12,17 @@ static struct Output** outputs = NULL;
 static size_t outputCount = 0;
 static struct View** views = NULL;
 static size_t viewCount = 0;
+static struct Pool outputPool;
+static struct Pool viewPool;
+
+static uint32_t GRIDDABLE_TYPES = 0;
 
 void meta_init() {
+    if (!grid_floatingDialogs) {
+        GRIDDABLE_TYPES |= WLC_BIT_MODAL;
+    }
+    initPool(&outputPool, sizeof(struct Output));
+    initPool(&viewPool, sizeof(struct View));
     views = malloc(MIN_VIEW_COUNT * sizeof(struct Window*));
     viewCount = MIN_VIEW_COUNT;
     for (size_t i = 0; i < viewCount; i++) {
@@ -20,6 +33,8 @@ void meta_init() {
 void meta_free() {
     free(views);
     free(outputs);
+    destroyPool(&viewPool);
+    destroyPool(&outputPool);
 }
 
 static size_t getViewsOccupancy() {
@@ -33,6 +48,10 @@ static size_t getViewsOccupancy() {
     return lowestShrinkThreshold;  // or less, we don't care
 }
 
+static bool isGriddable(wlc_handle const view) {
+    return !(wlc_view_get_type(view) & ~GRIDDABLE_TYPES);
+}
+
 struct Output* getOutput(wlc_handle output) {
     if (output >= outputCount) {
         return NULL;
@@ -57,20 +76,13 @@ struct Output* onOutputCreated(wlc_handle output) {
         }
     }
 
-    struct Output* outputMeta = malloc(sizeof(struct Output));  // TODO: check for failure
+    struct Output* outputMeta = poolAlloc(&outputPool);  // TODO: check for failure
     outputMeta->grid = createGrid(output);  // TODO: check for failure
+    initOverlay(&outputMeta->overlay);
 
     // wallpaper (this should be done in a client, but I'm lazy)
     const struct wlc_size* resolution = wlc_output_get_resolution(output);
-    uint32_t const width = resolution->w;
-    uint32_t const height = resolution->h;
-    outputMeta->wallpaper = malloc(width * height * sizeof(uint32_t));
-    for (size_t y = 0; y < height; y++) {
-        size_t startX = y * width;
-        for (size_t x = 0; x < width; x++) {
-            outputMeta->wallpaper[startX + x] = 0xff804000;
-        }
-    }
+    outputMeta->wallpaper = acquireWallpaper(resolution->w, resolution->h);
 
     outputs[output] = outputMeta;
     return outputMeta;
@@ -82,8 +94,14 @@ struct View* onViewCreated(wlc_handle view) {
         views = realloc(views, viewCount * sizeof(struct Window*));
     }
 
-    struct View* viewMeta = malloc(sizeof(struct View));
-    viewMeta->window = createWindow(view);
+    struct View* viewMeta = poolAlloc(&viewPool);
+    viewMeta->window = NULL;
+    if (isGriddable(view)) {
+        viewMeta->window = restoreWindow(view);
+        if (viewMeta->window == NULL) {
+            viewMeta->window = createWindow(view);
+        }
+    }
 
     views[view] = viewMeta;
     return viewMeta;
@@ -92,18 +110,21 @@ struct View* onViewCreated(wlc_handle view) {
 void onOutputDestroyed(wlc_handle output) {
     struct Output* outputMeta = getOutput(output);
     assert (outputMeta != NULL);
-    if (outputMeta->wallpaper != NULL) {
-        free(outputMeta->wallpaper);
-    }
-    free(outputMeta);
+    struct Output* targetOutput = getAnotherOutput(output);
+    evacuateGrid(outputMeta->grid, targetOutput == NULL ? NULL : targetOutput->grid);
+    destroyGrid(outputMeta->grid);
+    releaseWallpaper(outputMeta->wallpaper);
+    freeOverlay(&outputMeta->overlay);
+    poolFree(&outputPool, outputMeta);
     outputs[output] = NULL;
     // probably no need to shrink the array, people don't have THAT many screens
 }
 
 void onViewDestroyed(wlc_handle view) {
+    sessionViewDestroyed(view);
     destroyWindow(view);
 
-    free(views[view]);
+    poolFree(&viewPool, views[view]);
     views[view] = NULL;
 
     // shrink the array if below threshold
@@ -114,9 +135,9 @@ void onViewDestroyed(wlc_handle view) {
     }
 }
 
-struct Output* getAnOutput() {
+struct Output* getAnotherOutput(wlc_handle output) {
     for (size_t i = 0; i < outputCount; i++) {
-        if (outputs[i] != NULL) {
+        if (outputs[i] != NULL && i != output) {
             return outputs[i];
         }
     }
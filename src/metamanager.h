@@ -1,10 +1,15 @@
 #pragma once
 
 #include "grid.h"
+#include "painting.h"
+#include "wallpaper.h"
+
+#include <wlc/wlc.h>
 
 struct Output {
     struct Grid* grid;
-    uint32_t* wallpaper;  // TODO: Do in a client
+    struct Wallpaper* wallpaper;  // TODO: Do in a client, see wallpaper.h
+    struct Overlay overlay;
 };
 
 struct View {
@@ -23,4 +28,4 @@ struct View* onViewCreated(wlc_handle view);
 void onOutputDestroyed(wlc_handle output);
 void onViewDestroyed(wlc_handle view);
 
-struct Output* getAnOutput();
+struct Output* getAnotherOutput(wlc_handle output);
@@ -1,6 +1,7 @@
 #include "mouse.h"
 #include "config.h"
 #include "keyboard.h"
+#include "painting.h"
 
 #include <linux/input.h>
 #include <math.h>
@@ -25,10 +26,25 @@ enum MouseState mouseState = NORMAL;
 
 static double prevMouseX, prevMouseY;
 wlc_handle movedView = 0;
-static struct Window* resizedWindow = NULL;
-static struct Row* resizedRow = NULL;
-struct Edge* hoveredEdge = NULL;
-struct Edge* insertEdge = NULL;
+
+// gridded views and edges are dragged by griddrag.c, mouseState follows it
+static void beginGridResizeAt(wlc_handle const view) {
+    if (beginGridResize(view)) {
+        mouseState = gridDragState == GRID_DRAG_RESIZE_ROW ? RESIZING_ROW : RESIZING_WINDOW;
+        damageOverlays();
+    }
+}
+
+static void finishGridDrag() {
+    endGridDrag();
+    movedView = 0;
+    mouseState = NORMAL;
+    damageOverlays();
+}
+
+static bool edgeEquals(const struct Edge* a, const struct Edge* b) {
+    return a->type == b->type && a->row == b->row && a->window == b->window;
+}
 
 void sendButton(wlc_handle const view, uint32_t const button) {
     struct wl_client* const client = wlc_view_get_wl_client(view);
@@ -75,6 +91,8 @@ bool pointer_button(wlc_handle view, uint32_t time, const struct wlc_modifiers *
                             wlc_view_bring_to_front(movedView);
                         } else {
                             mouseState = MOVING_GRIDDED;
+                            beginGridMove(view);
+                            damageOverlays();
                         }
                         return true;
                     }
@@ -86,22 +104,7 @@ bool pointer_button(wlc_handle view, uint32_t time, const struct wlc_modifiers *
                             mouseState = RESIZING_FLOATING;
                             wlc_view_bring_to_front(movedView);
                         } else {
-                            struct Window* window = getWindow(view);
-                            assert (window != NULL);  // because we know it's not floating (must be gridded)
-                            enum wlc_resize_edge edge = getNearestEdgeOfView(view);
-                            bool previousEdge = edge & (WLC_RESIZE_EDGE_TOP | WLC_RESIZE_EDGE_LEFT);
-                            bool resizingRow = isRowEdge(edge);
-                            if (resizingRow) {
-                                resizedRow = previousEdge ? window->parent->prev : window->parent;
-                                if (resizedRow != NULL) {
-                                    mouseState = RESIZING_ROW;
-                                }
-                            } else {
-                                resizedWindow = previousEdge ? window->prev : window;
-                                if (resizedWindow != NULL) {
-                                    mouseState = RESIZING_WINDOW;
-                                }
-                            }
+                            beginGridResizeAt(view);
                         }
                         return true;
                     }
@@ -112,23 +115,11 @@ bool pointer_button(wlc_handle view, uint32_t time, const struct wlc_modifiers *
 
                     // edge mouse events (no view hovered)
 
-                    if (hoveredEdge != NULL && (button == BTN_LEFT || button == BTN_RIGHT)) {
+                    if (hoveredEdge.type != EDGE_NONE && (button == BTN_LEFT || button == BTN_RIGHT)) {
                         if (testKeystroke(&mousestroke_resize, mods, button)) {
                             setMouseModActionPerformed(&mouseBackMod);
                         }
-                        switch (hoveredEdge->type) {
-                            case EDGE_ROW:
-                                mouseState = RESIZING_ROW;
-                                resizedRow = hoveredEdge->row;
-                                break;
-                            case EDGE_WINDOW:
-                                mouseState = RESIZING_WINDOW;
-                                resizedWindow = hoveredEdge->window;
-                                break;
-                            case EDGE_CORNER: // TODO
-                            default:
-                                break;
-                        }
+                        beginGridResizeAt(0);
                         return true;
                     }
                 }
@@ -159,13 +150,7 @@ bool pointer_button(wlc_handle view, uint32_t time, const struct wlc_modifiers *
 
         case MOVING_GRIDDED: {
             if (state == WLC_BUTTON_STATE_RELEASED && button == BTN_LEFT) {
-                if (insertEdge != NULL) {
-                    moveViewToEdge(movedView, insertEdge);
-                    free(insertEdge);
-                    insertEdge = NULL;
-                }
-                movedView = 0;
-                mouseState = NORMAL;
+                finishGridDrag();  // drops the view at insertEdge
                 return true;
             }
             break;
@@ -183,8 +168,7 @@ bool pointer_button(wlc_handle view, uint32_t time, const struct wlc_modifiers *
         case RESIZING_WINDOW:
         case RESIZING_ROW: {
             if (state == WLC_BUTTON_STATE_RELEASED && (button == BTN_LEFT || button == BTN_RIGHT)) {
-                movedView = 0;
-                mouseState = NORMAL;
+                finishGridDrag();
                 return true;
             }
             break;
@@ -221,13 +205,15 @@ bool pointer_motion(wlc_handle view, uint32_t time, double x, double y) {
     // to be explicitly set after receiving the motion event:
     wlc_pointer_set_position_v2(x, y);
 
-    free(insertEdge);
-    insertEdge = NULL;
+    struct Edge const prevHoveredEdge = hoveredEdge;
+    struct Edge const prevInsertEdge = insertEdge;
 
     switch (mouseState) {
-        case NORMAL: {
-            free(hoveredEdge);
-            hoveredEdge = view ? NULL : getExactEdge(getGrid(wlc_get_focused_output()));
+        case NORMAL:
+        case MOVING_GRIDDED:
+        case RESIZING_ROW:
+        case RESIZING_WINDOW: {
+            gridPointerMotion(view, x - prevMouseX, y - prevMouseY);
             break;
         }
         case MOVING_FLOATING: {
@@ -237,6 +223,7 @@ bool pointer_motion(wlc_handle view, uint32_t time, double x, double y) {
             geom_new.origin.y = geom_start->origin.y + (uint32_t)round(y - prevMouseY);
             geom_new.size = geom_start->size;
             wlc_view_set_geometry(movedView, 0, &geom_new);
+            damageOverlays();
             break;
         }
         case RESIZING_FLOATING: {
@@ -249,36 +236,13 @@ bool pointer_motion(wlc_handle view, uint32_t time, double x, double y) {
             ensureMinSize(&geom_new.size.w);
             ensureMinSize(&geom_new.size.h);
             wlc_view_set_geometry(movedView, WLC_RESIZE_EDGE_BOTTOM_RIGHT, &geom_new);
+            damageOverlays();
             break;
         }
-        case MOVING_GRIDDED: {
-            insertEdge = getNearestEdge(getGrid(wlc_get_focused_output()));
+    }
 
-            // don't allow moving to the same position
-            if (doesEdgeBelongToView(insertEdge, movedView)) {
-                free(insertEdge);
-                insertEdge = NULL;
-            }
-            break;
-        }
-        case RESIZING_ROW: {
-            assert (resizedRow != NULL);  // because of condition for RESIZING_ROW
-            if (grid_horizontal) {
-                resizeRow(resizedRow, (int32_t)round(x - prevMouseX));
-            } else {
-                resizeRow(resizedRow, (int32_t)round(y - prevMouseY));
-            }
-            break;
-        }
-        case RESIZING_WINDOW: {
-            assert (resizedWindow);  // because of condition for RESIZING_WINDOW
-            if (grid_horizontal) {
-                resizeWindow(resizedWindow, (int32_t)round(y - prevMouseY));
-            } else {
-                resizeWindow(resizedWindow, (int32_t)round(x - prevMouseX));
-            }
-            break;
-        }
+    if (!edgeEquals(&hoveredEdge, &prevHoveredEdge) || !edgeEquals(&insertEdge, &prevInsertEdge)) {
+        damageOverlays();
     }
 
     prevMouseX = x;
@@ -306,5 +270,36 @@ bool pointer_scroll(wlc_handle view, uint32_t time, const struct wlc_modifiers*
 }
 
 void mouseHandleViewClosed(wlc_handle view) {
+    cancelGridDrag();
+    movedView = 0;
     mouseState = NORMAL;
 }
+
+// the grid moved or freed rows and windows, griddrag.c already forgot its Edges
+void mouseHandleEdgesInvalidated(bool const windowsFreed) {
+    invalidateOverlays();
+    if (windowsFreed) {
+        movedView = 0;
+        mouseState = NORMAL;
+    }
+}
+
+bool isRowEdge(enum wlc_resize_edge edge) {
+    bool horizontalEdge = edge & (WLC_RESIZE_EDGE_TOP | WLC_RESIZE_EDGE_BOTTOM);
+    return !grid_horizontal != !horizontalEdge;  // ! converts to bool (0 or 1)
+}
+
+enum wlc_resize_edge getNearestCornerOfView(wlc_handle view) {
+    double x, y;
+    wlc_pointer_get_position_v2(&x, &y);
+    const struct wlc_geometry* geom = wlc_view_get_geometry(view);
+    double distToTop = y - geom->origin.y;
+    double distToBtm = geom->origin.y + geom->size.h - y;
+    double distToLeft = x - geom->origin.x;
+    double distToRight = geom->origin.x + geom->size.w - x;
+
+    enum wlc_resize_edge closestHorizontalEdge = distToTop < distToBtm ? WLC_RESIZE_EDGE_TOP : WLC_RESIZE_EDGE_BOTTOM;
+    enum wlc_resize_edge closestVerticalEdge = distToLeft < distToRight ? WLC_RESIZE_EDGE_LEFT : WLC_RESIZE_EDGE_RIGHT;
+
+    return closestHorizontalEdge | closestVerticalEdge;
+}
@@ -1,6 +1,6 @@
 #pragma once
 
-#include "grid.h"
+#include "griddrag.h"
 
 #include <wlc/wlc.h>
 
@@ -14,8 +14,6 @@ extern enum MouseState {
 } mouseState;
 
 extern wlc_handle movedView;
-extern struct Edge* hoveredEdge;
-extern struct Edge* insertEdge;
 
 void sendButton(wlc_handle view, uint32_t button);
 
@@ -23,3 +21,7 @@ bool pointer_button(wlc_handle view, uint32_t time, const struct wlc_modifiers*
 bool pointer_motion(wlc_handle handle, uint32_t time, double x, double y);
 bool pointer_scroll(wlc_handle view, uint32_t time, const struct wlc_modifiers* modifiers, uint8_t axis_bits, double amount[2]);
 void mouseHandleViewClosed(wlc_handle view);
+void mouseHandleEdgesInvalidated(bool windowsFreed);
+
+bool isRowEdge(enum wlc_resize_edge edge);
+enum wlc_resize_edge getNearestCornerOfView(wlc_handle view);
@@ -1,11 +1,16 @@
 #include "painting.h"
 #include "config.h"
 #include "grid.h"
+#include "gridbackend.h"
 #include "mouse.h"
 #include "metamanager.h"
+#include "pixels.h"
 
 #include <wlc/wlc-render.h>
+#include <math.h>
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #define EDGE_WIDTH (grid_windowSpacing / 4)
 #define EDGE_START ((grid_windowSpacing - EDGE_WIDTH) / 2)
@@ -14,27 +19,239 @@
 #define EDGE_RESIZE_COLOR 0x80FFFFFF
 #define EDGE_MOVE_COLOR 0x800000FF
 #define WINDOW_MOVE_TINT 0x80000040
+#define WINDOW_GHOST_COLOR 0x400000FF
 #define WINDOW_INACTIVE_TINT 0xA0000000
 
-static void paintGeomColor(const struct wlc_geometry* geom, uint32_t color) {
-    uint32_t width = geom->size.w;
-    uint32_t height = geom->size.h;
-    uint32_t* data = malloc(width * height * sizeof(uint32_t));
-    for (size_t y = 0; y < height; y++) {
-        size_t startX = y * width;
-        for (size_t x = 0; x < width; x++) {
-            data[startX + x] = color;
+#define MIN(a, b) ((a) < (b) ? (a) : (b))
+#define MAX(a, b) ((a) > (b) ? (a) : (b))
+
+#define OVERLAY_MERGE_WASTE 2  // boxes are merged if their bounding box is at most this many times their area
+#define OVERLAY_MAX_BOXES 8    // past that, the boxes whose bounding box wastes the least are merged
+
+// overlay
+
+static uint64_t overlayGeneration = 1;  // new overlays are at 0, so they're always gathered first
+
+void initOverlay(struct Overlay* const overlay) {
+    *overlay = (struct Overlay){0, 0, NULL, 0, NULL, 0, 0, NULL, 0, 0, NULL, 0, 0};
+}
+
+void freeOverlay(struct Overlay* const overlay) {
+    free(overlay->pixels);
+    free(overlay->boxes);
+    free(overlay->rects);
+    free(overlay->paintedRects);
+    initOverlay(overlay);
+}
+
+static void paintGeomColor(struct Overlay* const overlay, const struct wlc_geometry* const geom, uint32_t const color) {
+    // clip to the output, so that the overlay never grows past it
+    const struct wlc_size* const resolution = wlc_output_get_resolution(overlay->output);
+    int64_t const left   = geom->origin.x < 0 ? 0 : geom->origin.x;
+    int64_t const top    = geom->origin.y < 0 ? 0 : geom->origin.y;
+    int64_t const right  = MIN((int64_t)geom->origin.x + geom->size.w, resolution->w);
+    int64_t const bottom = MIN((int64_t)geom->origin.y + geom->size.h, resolution->h);
+    if (right <= left || bottom <= top) {
+        return;
+    }
+    struct wlc_geometry const clipped = {{left, top}, {right - left, bottom - top}};
+    if (overlay->rectCount == overlay->rectCapacity) {
+        overlay->rectCapacity = overlay->rectCapacity == 0 ? 16 : overlay->rectCapacity * 2;
+        overlay->rects = realloc(overlay->rects, overlay->rectCapacity * sizeof(struct OverlayRect));
+    }
+    overlay->rects[overlay->rectCount++] = (struct OverlayRect){clipped, color};
+}
+
+void invalidateOverlays() {
+    overlayGeneration++;
+}
+
+void damageOverlays() {
+    invalidateOverlays();
+    size_t outputCount;
+    const wlc_handle* const outputs = wlc_get_outputs(&outputCount);
+    for (size_t i = 0; i < outputCount; i++) {
+        wlc_output_schedule_render(outputs[i]);
+    }
+}
+
+static bool overlayChanged(const struct Overlay* const overlay) {
+    return overlay->rectCount != overlay->paintedRectCount ||
+           memcmp(overlay->rects, overlay->paintedRects, overlay->rectCount * sizeof(struct OverlayRect)) != 0;
+}
+
+static uint64_t getArea(const struct wlc_geometry* const geom) {
+    return (uint64_t)geom->size.w * geom->size.h;
+}
+
+static struct wlc_geometry getBoundingBox(const struct wlc_geometry* const a, const struct wlc_geometry* const b) {
+    int32_t const left   = MIN(a->origin.x, b->origin.x);
+    int32_t const top    = MIN(a->origin.y, b->origin.y);
+    int32_t const right  = MAX(a->origin.x + (int32_t)a->size.w, b->origin.x + (int32_t)b->size.w);
+    int32_t const bottom = MAX(a->origin.y + (int32_t)a->size.h, b->origin.y + (int32_t)b->size.h);
+    return (struct wlc_geometry){{left, top}, {right - left, bottom - top}};
+}
+
+static bool geometriesIntersect(const struct wlc_geometry* const a, const struct wlc_geometry* const b) {
+    return a->origin.x < b->origin.x + (int32_t)b->size.w && b->origin.x < a->origin.x + (int32_t)a->size.w &&
+           a->origin.y < b->origin.y + (int32_t)b->size.h && b->origin.y < a->origin.y + (int32_t)a->size.h;
+}
+
+static bool geometryContains(const struct wlc_geometry* const outer, const struct wlc_geometry* const inner) {
+    return inner->origin.x >= outer->origin.x && inner->origin.y >= outer->origin.y &&
+           inner->origin.x + (int32_t)inner->size.w <= outer->origin.x + (int32_t)outer->size.w &&
+           inner->origin.y + (int32_t)inner->size.h <= outer->origin.y + (int32_t)outer->size.h;
+}
+
+// box j is merged into box i
+static void mergeBoxes(struct Overlay* const overlay, size_t const i, size_t const j) {
+    overlay->boxes[i].geometry = getBoundingBox(&overlay->boxes[i].geometry, &overlay->boxes[j].geometry);
+    overlay->boxes[j] = overlay->boxes[--overlay->boxCount];
+}
+
+// boxes that overlap are merged, since their pixels would be blended twice, and so are boxes whose bounding box
+// is at most OVERLAY_MERGE_WASTE times their area
+static void mergeCloseBoxes(struct Overlay* const overlay) {
+    for (size_t i = 0; i < overlay->boxCount; i++) {
+        for (size_t j = i + 1; j < overlay->boxCount; j++) {
+            const struct wlc_geometry* const a = &overlay->boxes[i].geometry;
+            const struct wlc_geometry* const b = &overlay->boxes[j].geometry;
+            struct wlc_geometry const bounds = getBoundingBox(a, b);
+            if (geometriesIntersect(a, b) || getArea(&bounds) <= OVERLAY_MERGE_WASTE * (getArea(a) + getArea(b))) {
+                mergeBoxes(overlay, i, j);
+                i = (size_t)-1;  // the grown box may reach boxes already looked at, start over
+                break;
+            }
         }
     }
-    wlc_pixels_write(WLC_RGBA8888, geom, data);
-    free(data);
 }
 
-static void tintView(wlc_handle const view, uint32_t color) {
-    paintGeomColor(wlc_view_get_geometry(view), color);
+// a few disjoint boxes covering the frame's rects
+static void findOverlayBoxes(struct Overlay* const overlay) {
+    if (overlay->rectCount > overlay->boxCapacity) {
+        overlay->boxCapacity = overlay->rectCount;
+        overlay->boxes = realloc(overlay->boxes, overlay->boxCapacity * sizeof(struct OverlayBox));
+    }
+    overlay->boxCount = overlay->rectCount;
+    for (size_t i = 0; i < overlay->rectCount; i++) {
+        overlay->boxes[i].geometry = overlay->rects[i].geometry;
+    }
+    mergeCloseBoxes(overlay);
+
+    while (overlay->boxCount > OVERLAY_MAX_BOXES) {
+        size_t bestI = 0, bestJ = 1;
+        uint64_t bestWaste = UINT64_MAX;
+        for (size_t i = 0; i < overlay->boxCount; i++) {
+            for (size_t j = i + 1; j < overlay->boxCount; j++) {
+                const struct wlc_geometry* const a = &overlay->boxes[i].geometry;
+                const struct wlc_geometry* const b = &overlay->boxes[j].geometry;
+                struct wlc_geometry const bounds = getBoundingBox(a, b);
+                uint64_t const waste = getArea(&bounds) - getArea(a) - getArea(b);
+                if (waste < bestWaste) {
+                    bestWaste = waste;
+                    bestI = i;
+                    bestJ = j;
+                }
+            }
+        }
+        mergeBoxes(overlay, bestI, bestJ);
+        mergeCloseBoxes(overlay);
+    }
+
+    size_t offset = 0;
+    for (size_t i = 0; i < overlay->boxCount; i++) {
+        overlay->boxes[i].offset = offset;
+        offset += getArea(&overlay->boxes[i].geometry);
+    }
 }
 
-static void tintViewEdge(wlc_handle const view, enum wlc_resize_edge edge, uint32_t color) {
+// draws the frame's rects into pixels, and keeps them as paintedRects
+static void redrawOverlay(struct Overlay* const overlay) {
+    findOverlayBoxes(overlay);
+    const struct OverlayBox* const lastBox = &overlay->boxes[overlay->boxCount - 1];
+    size_t const pixelCount = lastBox->offset + getArea(&lastBox->geometry);
+    if (pixelCount > overlay->pixelCapacity) {
+        free(overlay->pixels);
+        overlay->pixels = malloc(pixelCount * sizeof(uint32_t));
+        overlay->pixelCapacity = pixelCount;
+    }
+    // premultiplied "over", so the blended overlay looks the same as the rects painted one after another
+    memset(overlay->pixels, 0, pixelCount * sizeof(uint32_t));
+    for (size_t i = 0; i < overlay->rectCount; i++) {
+        const struct OverlayRect* const rect = &overlay->rects[i];
+        // each rect lies in a single box, since the boxes are disjoint bounding boxes of the rects
+        const struct OverlayBox* box = overlay->boxes;
+        while (!geometryContains(&box->geometry, &rect->geometry)) {
+            box++;
+        }
+        for (uint32_t y = 0; y < rect->geometry.size.h; y++) {
+            uint32_t* const row = overlay->pixels + box->offset +
+                                  (size_t)(rect->geometry.origin.y - box->geometry.origin.y + y) * box->geometry.size.w +
+                                  (rect->geometry.origin.x - box->geometry.origin.x);
+            blendPixels(row, rect->geometry.size.w, rect->color);
+        }
+    }
+
+    // the frame's rects become the painted ones, and the old painted array is reused for the next frame
+    struct OverlayRect* const rects = overlay->paintedRects;
+    size_t const rectCapacity = overlay->paintedRectCapacity;
+    overlay->paintedRects = overlay->rects;
+    overlay->paintedRectCount = overlay->rectCount;
+    overlay->paintedRectCapacity = overlay->rectCapacity;
+    overlay->rects = rects;
+    overlay->rectCapacity = rectCapacity;
+    paintingStats.overlayRedraws++;
+}
+
+static void beginOverlay(struct Overlay* const overlay, wlc_handle const output) {
+    overlay->output = output;
+    overlay->generation = overlayGeneration;
+    overlay->rectCount = 0;
+    paintingStats.overlayGathers++;
+}
+
+static void endOverlay(struct Overlay* const overlay) {
+    if (overlay->rectCount == 0) {
+        overlay->paintedRectCount = 0;
+    } else if (overlayChanged(overlay)) {
+        redrawOverlay(overlay);
+    }
+}
+
+// wlc draws every frame from scratch, so the overlay is written even when it's unchanged
+static void uploadOverlay(const struct Overlay* const overlay) {
+    if (overlay->paintedRectCount == 0) {
+        return;
+    }
+    for (size_t i = 0; i < overlay->boxCount; i++) {
+        const struct OverlayBox* const box = &overlay->boxes[i];
+        wlc_pixels_write(WLC_RGBA8888, &box->geometry, overlay->pixels + box->offset);
+    }
+}
+
+static void paintGeomOutline(struct Overlay* overlay, const struct wlc_geometry* geom, uint32_t width, uint32_t color) {
+    if (geom->size.w <= 2 * width || geom->size.h <= 2 * width) {
+        paintGeomColor(overlay, geom, color);
+        return;
+    }
+    struct wlc_geometry side = *geom;
+    side.size.h = width;
+    paintGeomColor(overlay, &side, color);
+    side.origin.y = geom->origin.y + geom->size.h - width;
+    paintGeomColor(overlay, &side, color);
+    side.origin.y = geom->origin.y + width;
+    side.size.w = width;
+    side.size.h = geom->size.h - 2 * width;
+    paintGeomColor(overlay, &side, color);
+    side.origin.x = geom->origin.x + geom->size.w - width;
+    paintGeomColor(overlay, &side, color);
+}
+
+static void tintView(struct Overlay* overlay, wlc_handle const view, uint32_t color) {
+    paintGeomColor(overlay, wlc_view_get_geometry(view), color);
+}
+
+static void tintViewEdge(struct Overlay* overlay, wlc_handle const view, enum wlc_resize_edge edge, uint32_t color) {
     struct wlc_geometry geom = *wlc_view_get_geometry(view);
     switch (edge) {
         case WLC_RESIZE_EDGE_BOTTOM:
@@ -60,11 +277,10 @@ static void tintViewEdge(wlc_handle const view, enum wlc_resize_edge edge, uint3
             geom.size.w = getMaxRowLength(wlc_view_get_output(view)) - grid_windowSpacing;
         }
     }
-    paintGeomColor(&geom, color);
+    paintGeomColor(overlay, &geom, color);
 }
 
-static void tintEdge(struct Edge* edge, uint32_t color) {
-    assert (edge != NULL);
+static void tintEdge(struct Overlay* overlay, const struct Edge* edge, uint32_t color) {
     double longScreenPos, latScreenPos;
     uint32_t longSize, latSize;
 
@@ -77,7 +293,7 @@ static void tintEdge(struct Edge* edge, uint32_t color) {
             if (row == NULL) {
                 longScreenPos = EDGE_START;
             } else {
-                longScreenPos = (int32_t) row->origin + row->size - row->parent->scroll + EDGE_START;
+                longScreenPos = getRowOrigin(row) + row->size - row->parent->scroll + EDGE_START;
             }
             break;
         }
@@ -85,7 +301,7 @@ static void tintEdge(struct Edge* edge, uint32_t color) {
         case EDGE_WINDOW: {
             struct Row* row = edge->row;
             struct Window* window = edge->window;
-            longScreenPos = (int32_t)row->origin - row->parent->scroll;
+            longScreenPos = getRowOrigin(row) - row->parent->scroll;
             longSize = row->size;
             latSize = EDGE_WIDTH;
             if (window == NULL) {
@@ -113,34 +329,221 @@ static void tintEdge(struct Edge* edge, uint32_t color) {
         geom.size.w   = latSize;
         geom.size.h   = longSize;
     }
-    paintGeomColor(&geom, color);
+    paintGeomColor(overlay, &geom, color);
+}
+
+// ghosts of where the windows would go if the moved view was dropped, windows that wouldn't move get none
+static void paintDropShadow(struct Overlay* overlay, const struct ShadowLayout* shadow) {
+    for (size_t i = 0; i < shadow->windowCount; i++) {
+        const struct ShadowWindow* ghost = &shadow->windows[i];
+        struct wlc_geometry const geom = {
+            {ghost->geometry.origin.x, ghost->geometry.origin.y},
+            {ghost->geometry.size.w, ghost->geometry.size.h}
+        };
+        if (ghost->view == movedView) {
+            paintGeomColor(overlay, &geom, WINDOW_GHOST_COLOR);
+        } else if (memcmp(&geom, wlc_view_get_geometry(ghost->view), sizeof(geom)) != 0) {
+            paintGeomOutline(overlay, &geom, EDGE_WIDTH, WINDOW_GHOST_COLOR);
+        }
+    }
+}
+
+// wallpaper (this should be done in a client, but I'm lazy)
+
+struct PaintingStats paintingStats = {0, 0, 0, 0, 0};
+
+struct Span {
+    int32_t start;
+    int32_t end;
+};
+
+// scratch space, reused every frame
+static struct wlc_geometry* coveredRects = NULL;
+static size_t coveredRectCapacity = 0;
+static int32_t* bandEdges = NULL;
+static struct Span* bandSpans = NULL;
+static uint32_t* wallpaperScratch = NULL;
+static size_t wallpaperScratchCapacity = 0;
+
+static int compareInt32(const void* a, const void* b) {
+    int32_t const ia = *(const int32_t*)a;
+    int32_t const ib = *(const int32_t*)b;
+    return (ia > ib) - (ia < ib);
+}
+
+static int compareSpans(const void* a, const void* b) {
+    return compareInt32(&((const struct Span*)a)->start, &((const struct Span*)b)->start);
+}
+
+static void growCoveredRects() {
+    coveredRectCapacity = coveredRectCapacity == 0 ? 64 : coveredRectCapacity * 2;
+    coveredRects = realloc(coveredRects, coveredRectCapacity * sizeof(struct wlc_geometry));
+    bandEdges = realloc(bandEdges, (2 * coveredRectCapacity + 2) * sizeof(int32_t));
+    bandSpans = realloc(bandSpans, coveredRectCapacity * sizeof(struct Span));
+}
+
+// what the windows shown on the grid are drawn at, scaled from the output's virtual resolution to its physical
+// one and clipped to it. Returns 0, so that the whole wallpaper is uploaded, if the scale isn't known.
+static size_t gatherCoveredRects(const struct Grid* const grid, struct wlc_size const resolution) {
+    const struct GridBackend* const backend = getGridBackend();
+    struct GridSize const virtualResolution = backend->getOutputSize(grid->output);
+    if (virtualResolution.w == 0 || virtualResolution.h == 0) {
+        return 0;
+    }
+    double const scaleX = (double)resolution.w / virtualResolution.w;
+    double const scaleY = (double)resolution.h / virtualResolution.h;
+
+    size_t count = 0;
+    for (const struct Row* row = grid->firstShownRow; row != NULL; row = row->next) {
+        for (const struct Window* window = row->firstWindow; window != NULL; window = window->next) {
+            if (!window->appliedMaskValid || window->appliedMask == 0) {
+                continue;
+            }
+            // the requested geometry isn't drawn until the client commits a buffer of that size
+            struct GridGeometry const geom = backend->getViewVisibleGeometry(window->view);
+            // rounded inwards, pixels the window only partly covers still get the wallpaper
+            int64_t const left   = MAX((int64_t)ceil(geom.origin.x * scaleX), 0);
+            int64_t const top    = MAX((int64_t)ceil(geom.origin.y * scaleY), 0);
+            int64_t const right  = MIN((int64_t)floor(((int64_t)geom.origin.x + geom.size.w) * scaleX), resolution.w);
+            int64_t const bottom = MIN((int64_t)floor(((int64_t)geom.origin.y + geom.size.h) * scaleY), resolution.h);
+            if (right > left && bottom > top) {
+                if (count == coveredRectCapacity) {
+                    growCoveredRects();
+                }
+                coveredRects[count++] = (struct wlc_geometry){{left, top}, {right - left, bottom - top}};
+            }
+        }
+        if (row == grid->lastShownRow) {
+            break;
+        }
+    }
+    return count;
+}
+
+static void uploadWallpaperRect(const uint32_t* const wallpaper, struct wlc_size const resolution,
+                                const struct wlc_geometry* const geom) {
+    size_t const pixelCount = (size_t)geom->size.w * geom->size.h;
+    const uint32_t* data = wallpaper + (size_t)geom->origin.y * resolution.w + geom->origin.x;
+    if (geom->size.w != resolution.w) {
+        // wlc_pixels_write takes tightly packed rows
+        if (pixelCount > wallpaperScratchCapacity) {
+            free(wallpaperScratch);
+            wallpaperScratch = malloc(pixelCount * sizeof(uint32_t));
+            wallpaperScratchCapacity = pixelCount;
+        }
+        for (uint32_t y = 0; y < geom->size.h; y++) {
+            memcpy(wallpaperScratch + (size_t)y * geom->size.w, data + (size_t)y * resolution.w,
+                   geom->size.w * sizeof(uint32_t));
+        }
+        data = wallpaperScratch;
+    }
+    wlc_pixels_write(WLC_RGBA8888, geom, data);
+    paintingStats.lastFrameWallpaperBytes += pixelCount * sizeof(uint32_t);
+}
+
+// Splits the output into horizontal bands at every top and bottom edge of a covered rect, so that each rect
+// either covers a band from top to bottom or not at all, and uploads the gaps between the rects of each band.
+// Bands that are uncovered from side to side are uploaded together.
+static void paintWallpaper(const struct Output* const outputMeta, struct wlc_size const resolution) {
+    if (coveredRectCapacity == 0) {
+        growCoveredRects();
+    }
+    size_t const rectCount = gatherCoveredRects(outputMeta->grid, resolution);
+
+    size_t edgeCount = 0;
+    bandEdges[edgeCount++] = 0;
+    bandEdges[edgeCount++] = resolution.h;
+    for (size_t i = 0; i < rectCount; i++) {
+        bandEdges[edgeCount++] = coveredRects[i].origin.y;
+        bandEdges[edgeCount++] = coveredRects[i].origin.y + coveredRects[i].size.h;
+    }
+    qsort(bandEdges, edgeCount, sizeof(int32_t), &compareInt32);
+
+    int32_t uncoveredTop = -1;  // top of the uncovered bands not uploaded yet, -1 if there are none
+    for (size_t e = 0; e + 1 < edgeCount; e++) {
+        int32_t const top = bandEdges[e];
+        int32_t const bottom = bandEdges[e + 1];
+        if (top == bottom) {
+            continue;
+        }
+        size_t spanCount = 0;
+        for (size_t i = 0; i < rectCount; i++) {
+            const struct wlc_geometry* const rect = &coveredRects[i];
+            if (rect->origin.y <= top && rect->origin.y + (int32_t)rect->size.h >= bottom) {
+                bandSpans[spanCount++] = (struct Span){rect->origin.x, rect->origin.x + rect->size.w};
+            }
+        }
+        if (spanCount == 0) {
+            if (uncoveredTop < 0) {
+                uncoveredTop = top;
+            }
+            continue;
+        }
+        if (uncoveredTop >= 0) {
+            struct wlc_geometry const geom = {{0, uncoveredTop}, {resolution.w, top - uncoveredTop}};
+            uploadWallpaperRect(outputMeta->wallpaper->pixels, resolution, &geom);
+            uncoveredTop = -1;
+        }
+
+        qsort(bandSpans, spanCount, sizeof(struct Span), &compareSpans);
+        int32_t x = 0;
+        for (size_t i = 0; i <= spanCount; i++) {
+            int32_t const gapEnd = i < spanCount ? bandSpans[i].start : (int32_t)resolution.w;
+            if (gapEnd > x) {
+                struct wlc_geometry const geom = {{x, top}, {gapEnd - x, bottom - top}};
+                uploadWallpaperRect(outputMeta->wallpaper->pixels, resolution, &geom);
+            }
+            if (i < spanCount) {
+                x = MAX(x, bandSpans[i].end);
+            }
+        }
+    }
+    if (uncoveredTop >= 0) {
+        struct wlc_geometry const geom = {{0, uncoveredTop}, {resolution.w, resolution.h - uncoveredTop}};
+        uploadWallpaperRect(outputMeta->wallpaper->pixels, resolution, &geom);
+    }
 }
 
 void output_render_pre(wlc_handle const output) {
-    // wallpaper (this should be done in a client, but I'm lazy)
+    flushGridLayout(getGrid(output));
+
     struct Output* outputMeta = getOutput(output);
     assert (outputMeta != NULL);
-    if (outputMeta->wallpaper != NULL) {
-        struct wlc_geometry geom;
-        geom.origin = (struct wlc_point) {0, 0};
-        geom.size = *wlc_output_get_resolution(output);
-        wlc_pixels_write(WLC_RGBA8888, &geom, outputMeta->wallpaper);
+    paintingStats.frames++;
+    paintingStats.lastFrameWallpaperBytes = 0;
+    const struct Wallpaper* wallpaper = outputMeta->wallpaper;
+    const struct wlc_size* resolution = wlc_output_get_resolution(output);
+    if (wallpaper != NULL && wallpaper->width == resolution->w && wallpaper->height == resolution->h) {
+        paintWallpaper(outputMeta, *resolution);
     }
+    paintingStats.wallpaperBytes += paintingStats.lastFrameWallpaperBytes;
 }
 
-void output_render_post(wlc_handle const output) {
-    if (hoveredEdge != NULL) {
-        tintEdge(hoveredEdge, EDGE_RESIZE_COLOR);
+void printPaintingStats() {
+    fprintf(stderr, "Wallpaper bytes uploaded: %lu in %lu frames\n",
+            (unsigned long)paintingStats.wallpaperBytes, (unsigned long)paintingStats.frames);
+    fprintf(stderr, "Overlay gathered in %lu and redrawn in %lu frames\n",
+            (unsigned long)paintingStats.overlayGathers, (unsigned long)paintingStats.overlayRedraws);
+}
+
+static void gatherOverlay(struct Overlay* const overlay, wlc_handle const output) {
+    beginOverlay(overlay, output);
+    if (hoveredEdge.type != EDGE_NONE) {
+        tintEdge(overlay, &hoveredEdge, EDGE_RESIZE_COLOR);
     }
-    if (insertEdge != NULL) {
-        tintEdge(insertEdge, EDGE_MOVE_COLOR);
+    if (insertEdge.type != EDGE_NONE) {
+        tintEdge(overlay, &insertEdge, EDGE_MOVE_COLOR);
+    }
+    const struct ShadowLayout* dropShadow = getDropShadow();
+    if (dropShadow != NULL && dropShadow->output == output) {
+        paintDropShadow(overlay, dropShadow);
     }
     if (mouseState == MOVING_GRIDDED && movedView > 0) {
-        tintView(movedView, WINDOW_MOVE_TINT);
+        tintView(overlay, movedView, WINDOW_MOVE_TINT);
     }
     /*const struct Row* hoveredRow = getHoveredRow(getGrid(output));
     if (hoveredRow != NULL) {
-        paintGeomColor(wlc_view_get_geometry(hoveredRow->firstWindow->view), 0x800000FF);
+        paintGeomColor(overlay, wlc_view_get_geometry(hoveredRow->firstWindow->view), 0x800000FF);
     }*/
 
     // dim inactive views
@@ -153,8 +556,17 @@ void output_render_post(wlc_handle const output) {
                 // view active
             } else {
                 // view inactive
-                tintView(view, WINDOW_INACTIVE_TINT);
+                tintView(overlay, view, WINDOW_INACTIVE_TINT);
             }
         }
     }
+    endOverlay(overlay);
+}
+
+void output_render_post(wlc_handle const output) {
+    struct Overlay* overlay = &getOutput(output)->overlay;
+    if (overlay->generation != overlayGeneration) {
+        gatherOverlay(overlay, output);
+    }
+    uploadOverlay(overlay);
 }
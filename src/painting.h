@@ -1,6 +1,57 @@
 #pragma once
 
 #include <wlc/defines.h>
+#include <wlc/geometry.h>
+
+#include <stddef.h>
+
+// Everything painted over the views in a frame is drawn into the output's overlay and uploaded with one
+// wlc_pixels_write per box: the rects' bounding boxes, merged where they overlap or lie so close that one upload
+// of their bounding box wastes little, so small rects far apart don't upload everything between them.
+// The pixels are kept between frames and only redrawn when the frame's rects differ from the ones they hold.
+// The rects themselves are only gathered again when the overlay generation moved past the overlay's, so a frame
+// in which nothing painted over the views changed doesn't look at the views at all.
+
+struct OverlayRect {
+    struct wlc_geometry geometry;  // clipped to the output
+    uint32_t color;
+};
+
+struct OverlayBox {
+    struct wlc_geometry geometry;
+    size_t offset;  // of its pixels in Overlay.pixels
+};
+
+struct Overlay {
+    wlc_handle output;
+    uint64_t generation;  // the overlay generation rects were gathered at
+    uint32_t* pixels;  // the boxes one after another, paintedRects blended into them in painting order
+    size_t pixelCapacity;
+    struct OverlayBox* boxes;  // disjoint, together they cover paintedRects
+    size_t boxCount;
+    size_t boxCapacity;
+    struct OverlayRect* rects;  // gathered for the current generation, in painting order
+    size_t rectCount;
+    size_t rectCapacity;
+    struct OverlayRect* paintedRects;  // the ones pixels hold
+    size_t paintedRectCount;
+    size_t paintedRectCapacity;
+};
+
+// wallpaper bytes passed to wlc_pixels_write, only the parts no gridded window covers are written
+extern struct PaintingStats {
+    uint64_t frames;
+    uint64_t wallpaperBytes;
+    uint64_t lastFrameWallpaperBytes;
+    uint64_t overlayGathers;  // frames in which the overlay rects were gathered again
+    uint64_t overlayRedraws;  // frames in which the overlay pixels were redrawn
+} paintingStats;
+
+void initOverlay(struct Overlay* overlay);
+void freeOverlay(struct Overlay* overlay);
+void invalidateOverlays();  // something the overlays show changed, they're gathered again in the next frame
+void damageOverlays();      // same, and schedules that frame on every output
 
 void output_render_pre(wlc_handle output);
 void output_render_post(wlc_handle output);
+void printPaintingStats();
@@ -0,0 +1,144 @@
+#include "pixels.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define PIXELS_X86
+#include <immintrin.h>
+#endif
+
+// scalar
+
+static void fillScalar(uint32_t* const dst, size_t const count, uint32_t const color) {
+    for (size_t i = 0; i < count; i++) {
+        dst[i] = color;
+    }
+}
+
+// dst * (255 - alpha) / 255, rounded, plus color, per channel
+static uint32_t blendPixel(uint32_t const dst, uint32_t const color) {
+    uint32_t const inverseAlpha = 255 - (color >> 24);
+    uint32_t result = 0;
+    for (unsigned shift = 0; shift < 32; shift += 8) {
+        uint32_t const channel = ((color >> shift) & 0xFF) + (((dst >> shift) & 0xFF) * inverseAlpha + 127) / 255;
+        result |= (channel > 0xFF ? 0xFF : channel) << shift;
+    }
+    return result;
+}
+
+static void blendScalar(uint32_t* const dst, size_t const count, uint32_t const color) {
+    for (size_t i = 0; i < count; i++) {
+        dst[i] = blendPixel(dst[i], color);
+    }
+}
+
+static const struct PixelKernels scalarKernels = {"scalar", &fillScalar, &blendScalar};
+
+#ifdef PIXELS_X86
+
+// The vector kernels blend in 16-bit lanes and divide by 255 as (t + 128 + ((t + 128) >> 8)) >> 8,
+// which is exact for every t up to 255 * 255, so they match blendPixel bit for bit.
+
+// sse2
+
+__attribute__((target("sse2")))
+static void fillSse2(uint32_t* const dst, size_t const count, uint32_t const color) {
+    __m128i const c = _mm_set1_epi32((int32_t)color);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        _mm_storeu_si128((__m128i*)(dst + i), c);
+    }
+    fillScalar(dst + i, count - i, color);
+}
+
+__attribute__((target("sse2")))
+static inline __m128i scaleSse2(__m128i const channels, __m128i const inverseAlpha) {
+    __m128i const t = _mm_add_epi16(_mm_mullo_epi16(channels, inverseAlpha), _mm_set1_epi16(128));
+    return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+}
+
+__attribute__((target("sse2")))
+static void blendSse2(uint32_t* const dst, size_t const count, uint32_t const color) {
+    __m128i const c = _mm_set1_epi32((int32_t)color);
+    __m128i const inverseAlpha = _mm_set1_epi16((int16_t)(255 - (color >> 24)));
+    __m128i const zero = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i const d = _mm_loadu_si128((const __m128i*)(dst + i));
+        __m128i const lo = scaleSse2(_mm_unpacklo_epi8(d, zero), inverseAlpha);
+        __m128i const hi = scaleSse2(_mm_unpackhi_epi8(d, zero), inverseAlpha);
+        _mm_storeu_si128((__m128i*)(dst + i), _mm_adds_epu8(_mm_packus_epi16(lo, hi), c));
+    }
+    blendScalar(dst + i, count - i, color);
+}
+
+static const struct PixelKernels sse2Kernels = {"sse2", &fillSse2, &blendSse2};
+
+// avx2, unpacking and packing both work within 128-bit lanes, so the pixels come back in order
+
+__attribute__((target("avx2")))
+static void fillAvx2(uint32_t* const dst, size_t const count, uint32_t const color) {
+    __m256i const c = _mm256_set1_epi32((int32_t)color);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        _mm256_storeu_si256((__m256i*)(dst + i), c);
+    }
+    fillScalar(dst + i, count - i, color);
+}
+
+__attribute__((target("avx2")))
+static inline __m256i scaleAvx2(__m256i const channels, __m256i const inverseAlpha) {
+    __m256i const t = _mm256_add_epi16(_mm256_mullo_epi16(channels, inverseAlpha), _mm256_set1_epi16(128));
+    return _mm256_srli_epi16(_mm256_add_epi16(t, _mm256_srli_epi16(t, 8)), 8);
+}
+
+__attribute__((target("avx2")))
+static void blendAvx2(uint32_t* const dst, size_t const count, uint32_t const color) {
+    __m256i const c = _mm256_set1_epi32((int32_t)color);
+    __m256i const inverseAlpha = _mm256_set1_epi16((int16_t)(255 - (color >> 24)));
+    __m256i const zero = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i const d = _mm256_loadu_si256((const __m256i*)(dst + i));
+        __m256i const lo = scaleAvx2(_mm256_unpacklo_epi8(d, zero), inverseAlpha);
+        __m256i const hi = scaleAvx2(_mm256_unpackhi_epi8(d, zero), inverseAlpha);
+        _mm256_storeu_si256((__m256i*)(dst + i), _mm256_adds_epu8(_mm256_packus_epi16(lo, hi), c));
+    }
+    blendSse2(dst + i, count - i, color);
+}
+
+static const struct PixelKernels avx2Kernels = {"avx2", &fillAvx2, &blendAvx2};
+
+#endif
+
+// dispatch
+
+static const struct PixelKernels* supportedKernels[3];
+static size_t supportedKernelCount = 0;
+static const struct PixelKernels* kernels = &scalarKernels;
+
+void pixels_init() {
+    supportedKernelCount = 0;
+    supportedKernels[supportedKernelCount++] = &scalarKernels;
+#ifdef PIXELS_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse2")) {
+        supportedKernels[supportedKernelCount++] = &sse2Kernels;
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        supportedKernels[supportedKernelCount++] = &avx2Kernels;
+    }
+#endif
+    kernels = supportedKernels[supportedKernelCount - 1];
+}
+
+void fillPixels(uint32_t* const dst, size_t const count, uint32_t const color) {
+    kernels->fill(dst, count, color);
+}
+
+void blendPixels(uint32_t* const dst, size_t const count, uint32_t const color) {
+    kernels->blend(dst, count, color);
+}
+
+size_t getSupportedPixelKernels(const struct PixelKernels* const** const result) {
+    *result = supportedKernels;
+    return supportedKernelCount;
+}
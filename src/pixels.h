@@ -0,0 +1,21 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Fill and blend kernels for the wallpaper and the overlays. Every kernel gives the same pixels,
+// pixels_init picks the fastest one the CPU supports.
+
+struct PixelKernels {
+    const char* name;
+    void (*fill)(uint32_t* dst, size_t count, uint32_t color);
+    void (*blend)(uint32_t* dst, size_t count, uint32_t color);
+};
+
+void pixels_init();
+
+void fillPixels(uint32_t* dst, size_t count, uint32_t color);
+void blendPixels(uint32_t* dst, size_t count, uint32_t color);  // premultiplied color over dst, saturated
+
+// the kernels this CPU supports, scalar first, for benchmarks and tests
+size_t getSupportedPixelKernels(const struct PixelKernels* const** kernels);
@@ -0,0 +1,73 @@
+#include "pool.h"
+
+#include <stdalign.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+#define SLAB_SIZE 16384
+
+void initPool(struct Pool* pool, size_t objectSize) {
+    // every object must be able to hold the free list link and stay aligned
+    size_t const alignment = alignof(max_align_t);
+    if (objectSize < sizeof(void*)) {
+        objectSize = sizeof(void*);
+    }
+    pool->objectSize = (objectSize + alignment - 1) / alignment * alignment;
+    pool->objectsPerSlab = SLAB_SIZE / pool->objectSize;
+    if (pool->objectsPerSlab == 0) {
+        pool->objectsPerSlab = 1;
+    }
+    pool->slabs = NULL;
+    pool->slabCount = 0;
+    pool->nextUnused = NULL;
+    pool->unusedCount = 0;
+    pool->freeList = NULL;
+}
+
+void destroyPool(struct Pool* pool) {
+    for (size_t i = 0; i < pool->slabCount; i++) {
+        free(pool->slabs[i]);
+    }
+    free(pool->slabs);
+    initPool(pool, pool->objectSize);
+}
+
+static bool addSlab(struct Pool* pool) {
+    char* const slab = malloc(pool->objectsPerSlab * pool->objectSize);
+    if (slab == NULL) {
+        return false;
+    }
+    char** const slabs = realloc(pool->slabs, (pool->slabCount + 1) * sizeof(char*));
+    if (slabs == NULL) {
+        free(slab);
+        return false;
+    }
+    pool->slabs = slabs;
+    pool->slabs[pool->slabCount++] = slab;
+    pool->nextUnused = slab;
+    pool->unusedCount = pool->objectsPerSlab;
+    return true;
+}
+
+void* poolAlloc(struct Pool* pool) {
+    if (pool->freeList != NULL) {
+        void* const object = pool->freeList;
+        pool->freeList = *(void**)object;
+        return object;
+    }
+    if (pool->unusedCount == 0 && !addSlab(pool)) {
+        return NULL;
+    }
+    void* const object = pool->nextUnused;
+    pool->nextUnused += pool->objectSize;
+    pool->unusedCount--;
+    return object;
+}
+
+void poolFree(struct Pool* pool, void* object) {
+    if (object == NULL) {
+        return;
+    }
+    *(void**)object = pool->freeList;
+    pool->freeList = object;
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <stddef.h>
+
+// Fixed-size object pool. Objects are carved out of large slabs, so objects allocated together sit next to
+// each other in memory, and freed objects are recycled by the pool instead of going back to libc.
+// Objects never move, so pointers to them stay valid until they are freed.
+
+struct Pool {
+    size_t objectSize;
+    size_t objectsPerSlab;
+    char** slabs;
+    size_t slabCount;
+    char* nextUnused;      // next never used object in the newest slab
+    size_t unusedCount;    // never used objects left in the newest slab
+    void* freeList;        // freed objects, linked through their first bytes
+};
+
+void initPool(struct Pool* pool, size_t objectSize);
+void destroyPool(struct Pool* pool);  // frees all objects at once
+void* poolAlloc(struct Pool* pool);
+void poolFree(struct Pool* pool, void* object);
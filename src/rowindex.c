@@ -0,0 +1,229 @@
+#include "rowindex.h"
+
+#include <assert.h>
+#include <stdlib.h>
+
+static uint32_t nextPriority() {
+    // xorshift, the priorities only need to be well distributed, not unpredictable
+    static uint32_t state = 2463534242;
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+static size_t getCount(const struct Row* node) {
+    return node == NULL ? 0 : node->indexCount;
+}
+
+static int64_t getLength(const struct Row* node) {
+    return node == NULL ? 0 : node->indexLength;
+}
+
+static void updateNode(struct Row* node) {
+    node->indexCount = 1 + getCount(node->indexLeft) + getCount(node->indexRight);
+    node->indexLength = (int64_t)node->size + grid_windowSpacing + getLength(node->indexLeft) + getLength(node->indexRight);
+}
+
+static void updatePath(struct Row* node) {
+    while (node != NULL) {
+        updateNode(node);
+        node = node->indexParent;
+    }
+}
+
+static void replaceChild(struct Grid* grid, struct Row* parent, const struct Row* oldChild, struct Row* newChild) {
+    if (parent == NULL) {
+        grid->rowIndexRoot = newChild;
+    } else if (parent->indexLeft == oldChild) {
+        parent->indexLeft = newChild;
+    } else {
+        assert (parent->indexRight == oldChild);
+        parent->indexRight = newChild;
+    }
+    if (newChild != NULL) {
+        newChild->indexParent = parent;
+    }
+}
+
+// lifts node above its parent, keeping the order of rows
+static void rotateUp(struct Grid* grid, struct Row* node) {
+    struct Row* const parent = node->indexParent;
+    assert (parent != NULL);
+    struct Row* const grandparent = parent->indexParent;
+    if (parent->indexLeft == node) {
+        parent->indexLeft = node->indexRight;
+        if (node->indexRight != NULL) {
+            node->indexRight->indexParent = parent;
+        }
+        node->indexRight = parent;
+    } else {
+        parent->indexRight = node->indexLeft;
+        if (node->indexLeft != NULL) {
+            node->indexLeft->indexParent = parent;
+        }
+        node->indexLeft = parent;
+    }
+    replaceChild(grid, grandparent, parent, node);
+    parent->indexParent = node;
+    updateNode(parent);
+    updateNode(node);
+}
+
+void rowIndexInsertAfter(struct Grid* grid, struct Row* row, struct Row* prev) {
+    row->indexLeft = NULL;
+    row->indexRight = NULL;
+    row->indexParent = NULL;
+    row->indexPriority = nextPriority();
+    updateNode(row);
+
+    // find the in-order successor slot of prev
+    struct Row* parent;
+    bool asLeftChild;
+    if (prev == NULL) {
+        parent = grid->rowIndexRoot;
+        while (parent != NULL && parent->indexLeft != NULL) {
+            parent = parent->indexLeft;
+        }
+        asLeftChild = true;
+    } else if (prev->indexRight == NULL) {
+        parent = prev;
+        asLeftChild = false;
+    } else {
+        parent = prev->indexRight;
+        while (parent->indexLeft != NULL) {
+            parent = parent->indexLeft;
+        }
+        asLeftChild = true;
+    }
+
+    if (parent == NULL) {
+        // tree is empty
+        grid->rowIndexRoot = row;
+        return;
+    }
+    if (asLeftChild) {
+        parent->indexLeft = row;
+    } else {
+        parent->indexRight = row;
+    }
+    row->indexParent = parent;
+    updatePath(parent);
+
+    // restore heap order
+    while (row->indexParent != NULL && row->indexParent->indexPriority < row->indexPriority) {
+        rotateUp(grid, row);
+    }
+}
+
+void rowIndexRemove(struct Grid* grid, struct Row* row) {
+    // rotate row down until it has at most one child
+    while (row->indexLeft != NULL && row->indexRight != NULL) {
+        struct Row* const child = row->indexLeft->indexPriority > row->indexRight->indexPriority ? row->indexLeft : row->indexRight;
+        rotateUp(grid, child);
+    }
+    struct Row* const child = row->indexLeft != NULL ? row->indexLeft : row->indexRight;
+    struct Row* const parent = row->indexParent;
+    replaceChild(grid, parent, row, child);
+    updatePath(parent);
+
+    row->indexParent = NULL;
+    row->indexLeft = NULL;
+    row->indexRight = NULL;
+}
+
+void rowIndexUpdate(struct Row* row) {
+    updatePath(row);
+}
+
+// joins two trees, all rows of left come before the rows of right
+static struct Row* merge(struct Row* left, struct Row* right) {
+    if (left == NULL) {
+        return right;
+    }
+    if (right == NULL) {
+        return left;
+    }
+    if (left->indexPriority > right->indexPriority) {
+        left->indexRight = merge(left->indexRight, right);
+        left->indexRight->indexParent = left;
+        updateNode(left);
+        return left;
+    } else {
+        right->indexLeft = merge(left, right->indexLeft);
+        right->indexLeft->indexParent = right;
+        updateNode(right);
+        return right;
+    }
+}
+
+void rowIndexAppend(struct Grid* grid, struct Grid* source) {
+    grid->rowIndexRoot = merge(grid->rowIndexRoot, source->rowIndexRoot);
+    if (grid->rowIndexRoot != NULL) {
+        grid->rowIndexRoot->indexParent = NULL;
+    }
+    source->rowIndexRoot = NULL;
+}
+
+int64_t rowIndexGetOrigin(const struct Row* row) {
+    int64_t origin = grid_windowSpacing + getLength(row->indexLeft);
+    for (const struct Row* node = row; node->indexParent != NULL; node = node->indexParent) {
+        const struct Row* const parent = node->indexParent;
+        if (parent->indexRight == node) {
+            origin += getLength(parent->indexLeft) + parent->size + grid_windowSpacing;
+        }
+    }
+    return origin;
+}
+
+size_t rowIndexGetPosition(const struct Row* row) {
+    size_t position = getCount(row->indexLeft);
+    for (const struct Row* node = row; node->indexParent != NULL; node = node->indexParent) {
+        const struct Row* const parent = node->indexParent;
+        if (parent->indexRight == node) {
+            position += getCount(parent->indexLeft) + 1;
+        }
+    }
+    return position;
+}
+
+int64_t rowIndexGetLength(const struct Grid* grid) {
+    return getLength(grid->rowIndexRoot);
+}
+
+size_t rowIndexGetCount(const struct Grid* grid) {
+    return getCount(grid->rowIndexRoot);
+}
+
+struct Row* rowIndexGetAt(const struct Grid* grid, size_t index) {
+    struct Row* node = grid->rowIndexRoot;
+    while (node != NULL) {
+        size_t const leftCount = getCount(node->indexLeft);
+        if (index < leftCount) {
+            node = node->indexLeft;
+        } else if (index == leftCount) {
+            return node;
+        } else {
+            index -= leftCount + 1;
+            node = node->indexRight;
+        }
+    }
+    return NULL;
+}
+
+struct Row* rowIndexFindEndingAfter(const struct Grid* grid, double const longPos) {
+    struct Row* found = NULL;
+    int64_t before = grid_windowSpacing;  // origin of the current subtree
+    struct Row* node = grid->rowIndexRoot;
+    while (node != NULL) {
+        int64_t const origin = before + getLength(node->indexLeft);
+        if (origin + node->size > longPos) {
+            found = node;
+            node = node->indexLeft;
+        } else {
+            before = origin + node->size + grid_windowSpacing;
+            node = node->indexRight;
+        }
+    }
+    return found;
+}
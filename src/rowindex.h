@@ -0,0 +1,19 @@
+#pragma once
+
+#include "grid.h"
+
+// The rows of a Grid are additionally kept in an implicit treap (ordered by their position in the grid).
+// Every node knows the row count and the summed length (row size + spacing) of its subtree,
+// so origins, positions and lookups by position or by index are all O(log n).
+
+void rowIndexInsertAfter(struct Grid* grid, struct Row* row, struct Row* prev);  // prev == NULL places row first
+void rowIndexRemove(struct Grid* grid, struct Row* row);
+void rowIndexUpdate(struct Row* row);  // call after changing row->size
+void rowIndexAppend(struct Grid* grid, struct Grid* source);  // moves all rows of source after the rows of grid
+
+int64_t rowIndexGetOrigin(const struct Row* row);
+size_t rowIndexGetPosition(const struct Row* row);
+int64_t rowIndexGetLength(const struct Grid* grid);  // end of the last row
+size_t rowIndexGetCount(const struct Grid* grid);
+struct Row* rowIndexGetAt(const struct Grid* grid, size_t index);
+struct Row* rowIndexFindEndingAfter(const struct Grid* grid, double longPos);  // first row with origin + size > longPos
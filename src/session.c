@@ -0,0 +1,517 @@
+#include "session.h"
+#include "config.h"
+#include "metamanager.h"
+
+#include <fcntl.h>
+#include <glib.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// The session is saved once the layout stayed the same for SESSION_SAVE_DELAY_MS. Views are matched to the saved
+// session for SESSION_RESTORE_TIMEOUT_MS after startup, or until all saved windows are back, and nothing is saved
+// before that, so a session that's still coming up doesn't overwrite the one it's restoring.
+#define SESSION_SAVE_DELAY_MS 1000
+#define SESSION_RESTORE_TIMEOUT_MS 60000
+
+#define SESSION_MAGIC "EWMSESSN"
+#define SESSION_VERSION 1
+
+// A session file is a SessionHeader followed by the SessionLayouts of all outputs, the SessionRows of all layouts,
+// the SessionWindows of all rows and a table of NUL terminated strings, all in the byte order of the machine.
+// Strings are offsets into the table, offset 0 is the empty string.
+
+struct SessionHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t layoutCount;
+    uint32_t rowCount;
+    uint32_t windowCount;
+    uint32_t stringsSize;
+    uint8_t horizontal;  // row sizes are only restored in the orientation they were saved in
+    uint8_t padding[3];
+};
+
+struct SessionLayout {
+    double scroll;
+    uint32_t outputName;
+    uint32_t rowCount;
+};
+
+struct SessionRow {
+    uint32_t size;
+    uint32_t windowCount;
+};
+
+struct SessionWindow {
+    uint32_t preferredWidth;
+    uint32_t preferredHeight;
+    uint32_t appId;
+    uint32_t title;
+};
+
+// restoring, the saved session stays mapped until it's over
+
+struct Slot {
+    const struct SessionWindow* saved;
+    uint32_t row;       // index into savedRows
+    bool claimed;
+    wlc_handle view;    // the view that claimed it, 0 once it's destroyed
+};
+
+struct RestoredLayout {
+    const struct SessionLayout* saved;
+    size_t firstSlot;
+    size_t slotCount;
+    size_t unclaimedCount;
+};
+
+static void* mapping = NULL;
+static size_t mappingSize = 0;
+static const struct SessionHeader* savedHeader = NULL;
+static const struct SessionRow* savedRows = NULL;
+static const char* savedStrings = NULL;
+static struct Slot* slots = NULL;  // NULL when not restoring
+static struct RestoredLayout* layouts = NULL;
+static size_t unclaimedCount = 0;
+static struct wlc_event_source* restoreTimer = NULL;
+
+// saving
+
+static struct wlc_event_source* saveTimer = NULL;
+static uint64_t seenState = 0;
+static uint64_t savedState = 0;
+
+static const char* orEmpty(const char* const string) {
+    return string == NULL ? "" : string;
+}
+
+static const char* getViewIdentity(wlc_handle const view) {
+    const char* identity = wlc_view_get_app_id(view);
+    if (identity == NULL || identity[0] == '\0') {
+        // X11 clients have a class instead
+        identity = wlc_view_get_class(view);
+    }
+    return orEmpty(identity);
+}
+
+static const char* getSavedString(uint32_t const offset) {
+    return savedStrings + offset;
+}
+
+// loading
+
+static void releaseSavedSession() {
+    free(slots);
+    free(layouts);
+    slots = NULL;
+    layouts = NULL;
+    unclaimedCount = 0;
+    if (mapping != NULL) {
+        munmap(mapping, mappingSize);
+        mapping = NULL;
+    }
+}
+
+static void endRestore() {
+    releaseSavedSession();
+    if (restoreTimer != NULL) {
+        wlc_event_source_remove(restoreTimer);
+        restoreTimer = NULL;
+    }
+}
+
+static int restoreTimedOut(void* arg) {
+    endRestore();
+    return 0;
+}
+
+// builds the slots, checking every count and string offset against the size of the file on the way,
+// so restoring can trust them
+static bool loadSession() {
+    if (mappingSize < sizeof(struct SessionHeader)) {
+        return false;
+    }
+    savedHeader = mapping;
+    if (memcmp(savedHeader->magic, SESSION_MAGIC, sizeof(savedHeader->magic)) != 0 ||
+        savedHeader->version != SESSION_VERSION) {
+        return false;
+    }
+    size_t const expectedSize = sizeof(struct SessionHeader) +
+                                savedHeader->layoutCount * sizeof(struct SessionLayout) +
+                                savedHeader->rowCount * sizeof(struct SessionRow) +
+                                savedHeader->windowCount * sizeof(struct SessionWindow) +
+                                savedHeader->stringsSize;
+    if (mappingSize != expectedSize || savedHeader->stringsSize == 0) {
+        return false;
+    }
+    const struct SessionLayout* const savedLayouts = (const void*)(savedHeader + 1);
+    savedRows = (const void*)(savedLayouts + savedHeader->layoutCount);
+    const struct SessionWindow* const savedWindows = (const void*)(savedRows + savedHeader->rowCount);
+    savedStrings = (const char*)(savedWindows + savedHeader->windowCount);
+    if (savedStrings[0] != '\0' || savedStrings[savedHeader->stringsSize - 1] != '\0') {
+        return false;
+    }
+
+    slots = malloc(savedHeader->windowCount * sizeof(struct Slot));
+    layouts = malloc(savedHeader->layoutCount * sizeof(struct RestoredLayout));
+    uint32_t r = 0;
+    uint32_t w = 0;
+    for (uint32_t l = 0; l < savedHeader->layoutCount; l++) {
+        const struct SessionLayout* const savedLayout = &savedLayouts[l];
+        if (savedLayout->outputName >= savedHeader->stringsSize ||
+            savedLayout->rowCount > savedHeader->rowCount - r) {
+            return false;
+        }
+        layouts[l] = (struct RestoredLayout){savedLayout, w, 0, 0};
+        for (uint32_t const layoutEnd = r + savedLayout->rowCount; r < layoutEnd; r++) {
+            uint32_t const windowCount = savedRows[r].windowCount;
+            if (windowCount == 0 || windowCount > savedHeader->windowCount - w) {
+                return false;
+            }
+            for (uint32_t const rowEnd = w + windowCount; w < rowEnd; w++) {
+                const struct SessionWindow* const savedWindow = &savedWindows[w];
+                if (savedWindow->appId >= savedHeader->stringsSize || savedWindow->title >= savedHeader->stringsSize) {
+                    return false;
+                }
+                slots[w] = (struct Slot){savedWindow, r, false, 0};
+            }
+        }
+        layouts[l].slotCount = w - layouts[l].firstSlot;
+        layouts[l].unclaimedCount = layouts[l].slotCount;
+    }
+    unclaimedCount = w;
+    return r == savedHeader->rowCount && w == savedHeader->windowCount;
+}
+
+static void mapSession(const char* const path) {
+    int const fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        // nothing saved yet
+        return;
+    }
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        mappingSize = st.st_size;
+        mapping = mmap(NULL, mappingSize, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping == MAP_FAILED) {
+            mapping = NULL;
+        }
+    }
+    close(fd);
+    if (mapping == NULL) {
+        return;
+    }
+    if (!loadSession()) {
+        fprintf(stderr, "Ignoring session file %s, it's damaged or of another version\n", path);
+        releaseSavedSession();
+    } else if (unclaimedCount == 0) {
+        releaseSavedSession();
+    }
+}
+
+// matching
+
+static struct RestoredLayout* findLayout(const char* const outputName) {
+    for (uint32_t l = 0; l < savedHeader->layoutCount; l++) {
+        if (strcmp(getSavedString(layouts[l].saved->outputName), outputName) == 0) {
+            return &layouts[l];
+        }
+    }
+    return NULL;
+}
+
+// prefers a slot with the same title, titles of the same app tell its windows apart at least until they change
+static struct Slot* findSlot(const struct RestoredLayout* const layout, const char* const identity, const char* const title) {
+    struct Slot* match = NULL;
+    for (size_t i = layout->firstSlot; i < layout->firstSlot + layout->slotCount; i++) {
+        struct Slot* const slot = &slots[i];
+        if (slot->claimed || strcmp(getSavedString(slot->saved->appId), identity) != 0) {
+            continue;
+        }
+        if (strcmp(getSavedString(slot->saved->title), title) == 0) {
+            return slot;
+        }
+        if (match == NULL) {
+            match = slot;
+        }
+    }
+    return match;
+}
+
+static struct Window* getRestoredWindow(const struct Slot* const slot, const struct Grid* const grid) {
+    if (slot->view == 0) {
+        return NULL;
+    }
+    struct Window* const window = getWindow(slot->view);
+    return window != NULL && window->parent->parent == grid ? window : NULL;
+}
+
+// The closest restored slot decides where the window goes: a slot of the same saved row if there is one,
+// otherwise the closest one before or after, so windows end up in their saved order whatever order their views
+// are created in.
+static bool findNeighborIn(ptrdiff_t const from, ptrdiff_t const to, const struct Grid* const grid,
+                           struct WindowPlacement* const placement) {
+    ptrdiff_t const step = from < to ? 1 : -1;
+    for (ptrdiff_t i = from; i != to; i += step) {
+        struct Window* const window = getRestoredWindow(&slots[i], grid);
+        if (window != NULL) {
+            placement->neighbor = window;
+            placement->before = step > 0;
+            return true;
+        }
+    }
+    return false;
+}
+
+static void findNeighbor(const struct RestoredLayout* const layout, const struct Slot* const slot,
+                         const struct Grid* const grid, struct WindowPlacement* const placement) {
+    ptrdiff_t const first = layout->firstSlot;
+    ptrdiff_t const last = first + layout->slotCount - 1;
+    ptrdiff_t const s = slot - slots;
+    ptrdiff_t rowFirst = s;
+    while (rowFirst > first && slots[rowFirst - 1].row == slot->row) {
+        rowFirst--;
+    }
+    ptrdiff_t rowLast = s;
+    while (rowLast < last && slots[rowLast + 1].row == slot->row) {
+        rowLast++;
+    }
+    placement->sameRow = true;
+    if (findNeighborIn(s - 1, rowFirst - 1, grid, placement) || findNeighborIn(s + 1, rowLast + 1, grid, placement)) {
+        return;
+    }
+    placement->sameRow = false;
+    if (!findNeighborIn(rowFirst - 1, first - 1, grid, placement)) {
+        findNeighborIn(rowLast + 1, last + 1, grid, placement);
+    }
+}
+
+struct Window* restoreWindow(wlc_handle const view) {
+    if (slots == NULL) {
+        return NULL;
+    }
+    wlc_handle const output = wlc_view_get_output(view);
+    struct RestoredLayout* const layout = findLayout(orEmpty(wlc_output_get_name(output)));
+    const char* const identity = getViewIdentity(view);
+    if (layout == NULL || layout->unclaimedCount == 0 || identity[0] == '\0') {
+        return NULL;
+    }
+    struct Slot* const slot = findSlot(layout, identity, orEmpty(wlc_view_get_title(view)));
+    if (slot == NULL) {
+        return NULL;
+    }
+
+    struct Grid* const grid = getGrid(output);
+    const struct SessionWindow* const saved = slot->saved;
+    uint32_t const rowSize = savedHeader->horizontal == grid_horizontal ? savedRows[slot->row].size : 0;
+    struct WindowPlacement placement = {NULL, false, false, rowSize, saved->preferredWidth, saved->preferredHeight};
+    findNeighbor(layout, slot, grid, &placement);
+    struct Window* const window = createWindowAt(view, &placement);
+
+    slot->claimed = true;
+    slot->view = view;
+    layout->unclaimedCount--;
+    unclaimedCount--;
+    if (layout->unclaimedCount == 0) {
+        // every row is back, so the saved scroll shows what it did
+        scrollGrid(grid, layout->saved->scroll - grid->scroll);
+    }
+    if (unclaimedCount == 0) {
+        endRestore();
+    }
+    return window;
+}
+
+void sessionViewDestroyed(wlc_handle const view) {
+    if (slots == NULL) {
+        return;
+    }
+    for (size_t i = 0; i < savedHeader->windowCount; i++) {
+        if (slots[i].view == view) {
+            slots[i].view = 0;
+        }
+    }
+}
+
+// saving
+
+struct SessionBuffer {
+    char* data;
+    size_t size;
+    size_t capacity;
+};
+
+static void appendToBuffer(struct SessionBuffer* const buffer, const void* const data, size_t const size) {
+    if (buffer->size + size > buffer->capacity) {
+        buffer->capacity = buffer->capacity == 0 ? 256 : buffer->capacity * 2;
+        if (buffer->capacity < buffer->size + size) {
+            buffer->capacity = buffer->size + size;
+        }
+        buffer->data = realloc(buffer->data, buffer->capacity);
+    }
+    memcpy(buffer->data + buffer->size, data, size);
+    buffer->size += size;
+}
+
+static uint32_t appendString(struct SessionBuffer* const strings, const char* const string) {
+    if (string == NULL || string[0] == '\0') {
+        return 0;
+    }
+    uint32_t const offset = strings->size;
+    appendToBuffer(strings, string, strlen(string) + 1);
+    return offset;
+}
+
+static bool writeBuffer(const struct SessionBuffer* const buffer, FILE* const file) {
+    return buffer->size == 0 || fwrite(buffer->data, buffer->size, 1, file) == 1;
+}
+
+static void appendLayout(struct SessionBuffer* const buffers, wlc_handle const output, const struct Grid* const grid) {
+    struct SessionBuffer* const layoutBuffer = &buffers[0];
+    struct SessionBuffer* const rowBuffer = &buffers[1];
+    struct SessionBuffer* const windowBuffer = &buffers[2];
+    struct SessionBuffer* const strings = &buffers[3];
+
+    struct SessionLayout layout = {grid->scroll, appendString(strings, wlc_output_get_name(output)), 0};
+    for (const struct Row* row = grid->firstRow; row != NULL; row = row->next) {
+        struct SessionRow savedRow = {row->size, 0};
+        for (const struct Window* window = row->firstWindow; window != NULL; window = window->next) {
+            struct SessionWindow const savedWindow = {
+                window->preferredWidth,
+                window->preferredHeight,
+                appendString(strings, getViewIdentity(window->view)),
+                appendString(strings, wlc_view_get_title(window->view)),
+            };
+            appendToBuffer(windowBuffer, &savedWindow, sizeof(savedWindow));
+            savedRow.windowCount++;
+        }
+        appendToBuffer(rowBuffer, &savedRow, sizeof(savedRow));
+        layout.rowCount++;
+    }
+    appendToBuffer(layoutBuffer, &layout, sizeof(layout));
+}
+
+// freed with g_free
+static char* getSessionPath() {
+    return g_build_filename(g_get_user_cache_dir(), SESSION_FILE_NAME, NULL);
+}
+
+// written next to the saved session and renamed over it, so a crash never leaves half a session behind
+static bool writeSession() {
+    struct SessionBuffer buffers[4] = {{NULL, 0, 0}, {NULL, 0, 0}, {NULL, 0, 0}, {NULL, 0, 0}};
+    appendToBuffer(&buffers[3], "", 1);
+    size_t outputCount;
+    const wlc_handle* const outputs = wlc_get_outputs(&outputCount);
+    for (size_t i = 0; i < outputCount; i++) {
+        struct Output* const outputMeta = getOutput(outputs[i]);
+        if (outputMeta != NULL) {
+            appendLayout(buffers, outputs[i], outputMeta->grid);
+        }
+    }
+
+    struct SessionHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SESSION_MAGIC, sizeof(header.magic));
+    header.version = SESSION_VERSION;
+    header.layoutCount = buffers[0].size / sizeof(struct SessionLayout);
+    header.rowCount = buffers[1].size / sizeof(struct SessionRow);
+    header.windowCount = buffers[2].size / sizeof(struct SessionWindow);
+    header.stringsSize = buffers[3].size;
+    header.horizontal = grid_horizontal;
+
+    char* const path = getSessionPath();
+    char* const tempPath = g_strconcat(path, ".tmp", NULL);
+    FILE* const file = g_mkdir_with_parents(g_get_user_cache_dir(), 0700) == 0 ? fopen(tempPath, "wb") : NULL;
+    bool written = file != NULL && fwrite(&header, sizeof(header), 1, file) == 1;
+    for (size_t i = 0; i < 4; i++) {
+        written = written && writeBuffer(&buffers[i], file);
+        free(buffers[i].data);
+    }
+    if (file != NULL) {
+        written = fclose(file) == 0 && written;
+        written = written && rename(tempPath, path) == 0;
+        if (!written) {
+            remove(tempPath);
+        }
+    }
+    if (!written) {
+        fprintf(stderr, "Cannot save session to %s\n", path);
+    }
+    g_free(path);
+    g_free(tempPath);
+    return written;
+}
+
+static uint64_t mixState(uint64_t const state, uint64_t const value) {
+    return (state ^ value) * 1099511628211u;
+}
+
+// changes whenever an output's rows, windows or scroll do
+static uint64_t getSessionState() {
+    uint64_t state = 14695981039346656037u;
+    size_t outputCount;
+    const wlc_handle* const outputs = wlc_get_outputs(&outputCount);
+    for (size_t i = 0; i < outputCount; i++) {
+        const struct Output* const outputMeta = getOutput(outputs[i]);
+        if (outputMeta == NULL) {
+            continue;
+        }
+        uint64_t scroll;
+        memcpy(&scroll, &outputMeta->grid->scroll, sizeof(scroll));
+        state = mixState(state, outputs[i]);
+        state = mixState(state, outputMeta->grid->changeCount);
+        state = mixState(state, scroll);
+    }
+    return state;
+}
+
+void saveSession() {
+    if (slots != NULL) {
+        // still restoring
+        return;
+    }
+    uint64_t const state = getSessionState();
+    if (state != savedState) {
+        if (writeSession()) {
+            savedState = state;  // a failed save is retried at the next check
+        }
+        seenState = state;
+    }
+}
+
+// polled, rather than hooked into every change, so saving costs the hot paths nothing
+static int checkSession(void* arg) {
+    uint64_t const state = getSessionState();
+    if (state != seenState) {
+        // still changing, wait for it to settle
+        seenState = state;
+    } else {
+        saveSession();
+    }
+    wlc_event_source_timer_update(saveTimer, SESSION_SAVE_DELAY_MS);
+    return 0;
+}
+
+void session_init() {
+    char* const path = getSessionPath();
+    mapSession(path);
+    g_free(path);
+    if (slots != NULL) {
+        restoreTimer = wlc_event_loop_add_timer(&restoreTimedOut, NULL);
+        wlc_event_source_timer_update(restoreTimer, SESSION_RESTORE_TIMEOUT_MS);
+    }
+    saveTimer = wlc_event_loop_add_timer(&checkSession, NULL);
+    wlc_event_source_timer_update(saveTimer, SESSION_SAVE_DELAY_MS);
+}
+
+// the event loop is gone by now, and its timers with it
+void session_free() {
+    releaseSavedSession();
+    restoreTimer = NULL;
+    saveTimer = NULL;
+}
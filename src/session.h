@@ -0,0 +1,18 @@
+#pragma once
+
+#include "grid.h"
+
+#include <wlc/wlc.h>
+
+// The layout of every output is saved to SESSION_FILE_NAME a moment after it stops changing, and restored from it
+// after a restart: views are matched to the windows they had by app id (or class) and title, and created straight
+// in their saved rows, with their saved sizes.
+
+#define SESSION_FILE_NAME "endlesswm-session"  // in $XDG_CACHE_HOME, or ~/.cache if that's not set
+
+void session_init();  // loads the saved session and starts saving, call after wlc_init
+void session_free();
+
+void saveSession();  // saves right away if anything changed since the last save, e.g. before terminating
+struct Window* restoreWindow(wlc_handle view);  // returns NULL if view has no place in the saved session
+void sessionViewDestroyed(wlc_handle view);
@@ -0,0 +1,219 @@
+#include "trace.h"
+#include "config.h"
+#include "keyboard.h"
+#include "mouse.h"
+#include "painting.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define TRACE_BUFFER_SIZE 65536
+
+static FILE* traceFile = NULL;
+static uint64_t traceEpoch;
+
+static uint64_t now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+void trace_init() {
+    const char* const path = getenv(TRACE_PATH_VARIABLE);
+    if (path == NULL || path[0] == '\0') {
+        return;
+    }
+    traceFile = fopen(path, "wb");
+    if (traceFile == NULL) {
+        fprintf(stderr, "Cannot open trace file %s\n", path);
+        return;
+    }
+    setvbuf(traceFile, NULL, _IOFBF, TRACE_BUFFER_SIZE);
+
+    struct TraceHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, TRACE_MAGIC, sizeof(header.magic));
+    header.version = TRACE_VERSION;
+    header.eventSize = sizeof(struct TraceEvent);
+    header.gridWindowSpacing = grid_windowSpacing;
+    header.gridHorizontal = grid_horizontal;
+    header.gridMinimizeEmptySpace = grid_minimizeEmptySpace;
+    header.behaviorScrollMult = behavior_scrollMult;
+    fwrite(&header, sizeof(header), 1, traceFile);
+    traceEpoch = now();
+}
+
+void trace_free() {
+    if (traceFile != NULL) {
+        fclose(traceFile);
+        traceFile = NULL;
+    }
+}
+
+uint64_t traceStart() {
+    return traceFile == NULL ? 0 : now();
+}
+
+static void writeEvent(struct TraceEvent* const event, enum TraceEventType const type, uint64_t const start) {
+    uint64_t const end = now();
+    event->time = start - traceEpoch;
+    event->duration = (uint32_t)(end - start);
+    event->type = type;
+    fwrite(event, sizeof(struct TraceEvent), 1, traceFile);
+}
+
+static void initEvent(struct TraceEvent* const event, wlc_handle const view, wlc_handle const output) {
+    memset(event, 0, sizeof(struct TraceEvent));
+    event->view = view;
+    event->output = output;
+}
+
+static enum TraceMouseState getTraceMouseState() {
+    switch (mouseState) {
+        case NORMAL: return TRACE_MOUSE_NORMAL;
+        case MOVING_GRIDDED: return TRACE_MOUSE_MOVING_GRIDDED;
+        case RESIZING_WINDOW: return TRACE_MOUSE_RESIZING_WINDOW;
+        case RESIZING_ROW: return TRACE_MOUSE_RESIZING_ROW;
+        default: return TRACE_MOUSE_OTHER;
+    }
+}
+
+// lifecycle callbacks
+
+void traceOutputCreated(wlc_handle const output, uint64_t const start) {
+    if (traceFile == NULL) {
+        return;
+    }
+    struct TraceEvent event;
+    initEvent(&event, 0, output);
+    const struct wlc_size* const resolution = wlc_output_get_virtual_resolution(output);
+    event.outputCreated.w = resolution->w;
+    event.outputCreated.h = resolution->h;
+    writeEvent(&event, TRACE_OUTPUT_CREATED, start);
+}
+
+void traceOutputDestroyed(wlc_handle const output, uint64_t const start) {
+    if (traceFile == NULL) {
+        return;
+    }
+    struct TraceEvent event;
+    initEvent(&event, 0, output);
+    writeEvent(&event, TRACE_OUTPUT_DESTROYED, start);
+}
+
+void traceViewCreated(wlc_handle const view, uint64_t const start) {
+    if (traceFile == NULL) {
+        return;
+    }
+    struct TraceEvent event;
+    initEvent(&event, view, wlc_view_get_output(view));
+    const struct wlc_geometry* const geometry = wlc_view_get_geometry(view);
+    event.viewCreated.parent = wlc_view_get_parent(view);
+    event.viewCreated.w = geometry->size.w;
+    event.viewCreated.h = geometry->size.h;
+    event.viewCreated.gridded = isGridded(view);
+    writeEvent(&event, TRACE_VIEW_CREATED, start);
+}
+
+void traceViewDestroyed(wlc_handle const view, uint64_t const start) {
+    if (traceFile == NULL) {
+        return;
+    }
+    struct TraceEvent event;
+    initEvent(&event, view, 0);
+    writeEvent(&event, TRACE_VIEW_DESTROYED, start);
+}
+
+void traceGridCommand(enum GridCommand const command, wlc_handle const view, int32_t const count, uint64_t const start) {
+    if (traceFile == NULL) {
+        return;
+    }
+    struct TraceEvent event;
+    initEvent(&event, view, wlc_get_focused_output());
+    event.command.command = command;
+    event.command.count = count;
+    writeEvent(&event, TRACE_COMMAND, start);
+}
+
+// input callbacks
+
+bool traced_keyboard_key(wlc_handle const view, uint32_t const time, const struct wlc_modifiers* const modifiers, uint32_t const key, enum wlc_key_state const state) {
+    if (traceFile == NULL) {
+        return keyboard_key(view, time, modifiers, key, state);
+    }
+    uint64_t const start = now();
+    struct TraceEvent event;
+    initEvent(&event, view, wlc_get_focused_output());
+    event.key.mods = modifiers->mods;
+    event.key.key = key;
+    event.key.state = state;
+    bool const handled = keyboard_key(view, time, modifiers, key, state);
+    event.flags = handled ? TRACE_HANDLED : 0;
+    writeEvent(&event, TRACE_KEY, start);
+    return handled;
+}
+
+bool traced_pointer_button(wlc_handle const view, uint32_t const time, const struct wlc_modifiers* const modifiers, uint32_t const button, enum wlc_button_state const state, const struct wlc_point* const position) {
+    if (traceFile == NULL) {
+        return pointer_button(view, time, modifiers, button, state, position);
+    }
+    uint64_t const start = now();
+    struct TraceEvent event;
+    initEvent(&event, view, wlc_get_focused_output());
+    event.button.mods = modifiers->mods;
+    event.button.button = button;
+    event.button.state = state;
+    event.button.mouseStateBefore = getTraceMouseState();
+    bool const handled = pointer_button(view, time, modifiers, button, state, position);
+    event.button.mouseStateAfter = getTraceMouseState();
+    event.flags = handled ? TRACE_HANDLED : 0;
+    writeEvent(&event, TRACE_POINTER_BUTTON, start);
+    return handled;
+}
+
+bool traced_pointer_motion(wlc_handle const view, uint32_t const time, double const x, double const y) {
+    if (traceFile == NULL) {
+        return pointer_motion(view, time, x, y);
+    }
+    uint64_t const start = now();
+    struct TraceEvent event;
+    initEvent(&event, view, wlc_get_focused_output());
+    event.motion.x = x;
+    event.motion.y = y;
+    event.motion.mouseState = getTraceMouseState();
+    bool const handled = pointer_motion(view, time, x, y);
+    event.flags = handled ? TRACE_HANDLED : 0;
+    writeEvent(&event, TRACE_POINTER_MOTION, start);
+    return handled;
+}
+
+bool traced_pointer_scroll(wlc_handle const view, uint32_t const time, const struct wlc_modifiers* const modifiers, uint8_t const axis_bits, double amount[2]) {
+    if (traceFile == NULL) {
+        return pointer_scroll(view, time, modifiers, axis_bits, amount);
+    }
+    uint64_t const start = now();
+    struct TraceEvent event;
+    initEvent(&event, view, wlc_get_focused_output());
+    event.scroll.mods = modifiers->mods;
+    event.scroll.axisBits = axis_bits;
+    event.scroll.amount[0] = amount[0];
+    event.scroll.amount[1] = amount[1];
+    bool const handled = pointer_scroll(view, time, modifiers, axis_bits, amount);
+    event.flags = handled ? TRACE_HANDLED : 0;
+    writeEvent(&event, TRACE_POINTER_SCROLL, start);
+    return handled;
+}
+
+void traced_output_render_pre(wlc_handle const output) {
+    if (traceFile == NULL) {
+        output_render_pre(output);
+        return;
+    }
+    uint64_t const start = now();
+    struct TraceEvent event;
+    initEvent(&event, 0, output);
+    output_render_pre(output);
+    writeEvent(&event, TRACE_FRAME, start);
+}
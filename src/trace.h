@@ -0,0 +1,27 @@
+#pragma once
+
+#include "gridcommand.h"
+#include "traceformat.h"
+
+#include <stdbool.h>
+#include <wlc/wlc.h>
+
+#define TRACE_PATH_VARIABLE "ENDLESSWM_TRACE"
+
+void trace_init();  // starts recording if TRACE_PATH_VARIABLE names a file
+void trace_free();
+
+// the input callbacks, recorded
+bool traced_keyboard_key(wlc_handle view, uint32_t time, const struct wlc_modifiers* modifiers, uint32_t key, enum wlc_key_state state);
+bool traced_pointer_button(wlc_handle view, uint32_t time, const struct wlc_modifiers* modifiers, uint32_t button, enum wlc_button_state state, const struct wlc_point* position);
+bool traced_pointer_motion(wlc_handle view, uint32_t time, double x, double y);
+bool traced_pointer_scroll(wlc_handle view, uint32_t time, const struct wlc_modifiers* modifiers, uint8_t axis_bits, double amount[2]);
+void traced_output_render_pre(wlc_handle output);
+
+// lifecycle callbacks record themselves, start is the value of traceStart before handling
+uint64_t traceStart();
+void traceOutputCreated(wlc_handle output, uint64_t start);
+void traceOutputDestroyed(wlc_handle output, uint64_t start);
+void traceViewCreated(wlc_handle view, uint64_t start);
+void traceViewDestroyed(wlc_handle view, uint64_t start);
+void traceGridCommand(enum GridCommand command, wlc_handle view, int32_t count, uint64_t start);
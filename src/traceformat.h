@@ -0,0 +1,94 @@
+#pragma once
+
+#include <stdint.h>
+
+// Binary trace of the compositor's callbacks, written by trace.c and read by grid_replay.
+// A trace is a TraceHeader followed by TraceEvents, all in the byte order of the recording machine.
+
+#define TRACE_MAGIC "EWMTRACE"
+#define TRACE_VERSION 2
+
+struct TraceHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t eventSize;  // sizeof(struct TraceEvent)
+
+    // config the recorded session depended on
+    uint32_t gridWindowSpacing;
+    uint8_t gridHorizontal;
+    uint8_t gridMinimizeEmptySpace;
+    uint16_t padding;
+    double behaviorScrollMult;
+};
+
+enum TraceEventType {
+    TRACE_OUTPUT_CREATED,
+    TRACE_OUTPUT_DESTROYED,
+    TRACE_VIEW_CREATED,
+    TRACE_VIEW_DESTROYED,
+    TRACE_KEY,
+    TRACE_POINTER_BUTTON,
+    TRACE_POINTER_MOTION,
+    TRACE_POINTER_SCROLL,
+    TRACE_FRAME,            // output_render_pre, where the grid's layout is flushed
+    TRACE_COMMAND,          // a grid command run by a key, written before the key's event
+    TRACE_EVENT_TYPE_COUNT
+};
+
+#define TRACE_HANDLED 1     // the callback returned true
+
+// mouse states, as far as the replay cares about them
+enum TraceMouseState {
+    TRACE_MOUSE_NORMAL,
+    TRACE_MOUSE_MOVING_GRIDDED,
+    TRACE_MOUSE_RESIZING_WINDOW,
+    TRACE_MOUSE_RESIZING_ROW,
+    TRACE_MOUSE_OTHER
+};
+
+struct TraceEvent {
+    uint64_t time;          // ns since the recording started
+    uint32_t duration;      // ns the compositor spent in the callback
+    uint16_t type;
+    uint16_t flags;
+    uint32_t view;
+    uint32_t output;        // for input events, the focused output
+    union {
+        struct {
+            uint32_t w;
+            uint32_t h;
+        } outputCreated;    // virtual resolution
+        struct {
+            uint32_t parent;
+            uint32_t w;
+            uint32_t h;
+            uint32_t gridded;
+        } viewCreated;
+        struct {
+            uint32_t mods;
+            uint32_t key;
+            uint32_t state;
+        } key;
+        struct {
+            uint32_t mods;
+            uint32_t button;
+            uint32_t state;
+            uint32_t mouseStateBefore;
+            uint32_t mouseStateAfter;
+        } button;
+        struct {
+            double x;
+            double y;
+            uint32_t mouseState;  // before the motion was handled
+        } motion;
+        struct {
+            uint32_t mods;
+            uint32_t axisBits;
+            double amount[2];
+        } scroll;
+        struct {
+            uint32_t command;  // enum GridCommand
+            int32_t count;
+        } command;
+    };
+};
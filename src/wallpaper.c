@@ -0,0 +1,260 @@
+#include "wallpaper.h"
+#include "config.h"
+#include "pixels.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <gdk-pixbuf/gdk-pixbuf.h>
+#include <glib.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define WALLPAPER_MAGIC "EWMWALLP"
+#define WALLPAPER_VERSION 1
+
+// A cache file is a WallpaperCacheHeader, the image path padded to 4 bytes and width * height pixels.
+// The key and path are compared in full, the file name is only a hash of them.
+
+struct WallpaperKey {
+    uint32_t width;
+    uint32_t height;
+    uint32_t color;
+    uint32_t pathLength;  // 0 for a plain color
+    int64_t mtime;
+    int64_t mtimeNsec;
+    uint64_t fileSize;
+};
+
+struct WallpaperCacheHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t padding;
+    struct WallpaperKey key;
+};
+
+static struct Wallpaper* wallpapers = NULL;  // loaded ones, to share
+
+static size_t getPixelOffset(const struct WallpaperKey* const key) {
+    return sizeof(struct WallpaperCacheHeader) + (key->pathLength + 3) / 4 * 4;
+}
+
+static size_t getCacheFileSize(const struct WallpaperKey* const key) {
+    return getPixelOffset(key) + (size_t)key->width * key->height * sizeof(uint32_t);
+}
+
+// returns the image to draw, NULL if there's none or it can't be read
+static const char* getWallpaperKey(uint32_t const width, uint32_t const height, struct WallpaperKey* const key) {
+    *key = (struct WallpaperKey){width, height, appearance_wallpaperColor, 0, 0, 0, 0};
+    const char* const imagePath = appearance_wallpaperImage;
+    if (imagePath == NULL) {
+        return NULL;
+    }
+    struct stat st;
+    if (stat(imagePath, &st) != 0) {
+        fprintf(stderr, "Cannot read wallpaper %s\n", imagePath);
+        return NULL;
+    }
+    key->pathLength = strlen(imagePath);
+    key->mtime = st.st_mtim.tv_sec;
+    key->mtimeNsec = st.st_mtim.tv_nsec;
+    key->fileSize = st.st_size;
+    return imagePath;
+}
+
+static uint64_t hashBytes(uint64_t hash, const void* const data, size_t const size) {
+    const unsigned char* const bytes = data;
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ bytes[i]) * 1099511628211u;
+    }
+    return hash;
+}
+
+// cache
+
+// both paths are freed with g_free
+static char* getCacheDirPath() {
+    return g_build_filename(g_get_user_cache_dir(), WALLPAPER_CACHE_DIR, NULL);
+}
+
+static char* getCachePath(const struct WallpaperKey* const key, const char* const imagePath) {
+    uint64_t hash = hashBytes(14695981039346656037u, key, sizeof(*key));
+    hash = hashBytes(hash, imagePath, key->pathLength);
+    char fileName[64];
+    snprintf(fileName, sizeof(fileName), "%ux%u-%016llx", key->width, key->height, (unsigned long long)hash);
+    char* const cacheDirPath = getCacheDirPath();
+    char* const cachePath = g_build_filename(cacheDirPath, fileName, NULL);
+    g_free(cacheDirPath);
+    return cachePath;
+}
+
+// only the current wallpaper of each resolution is worth keeping
+static void removeStaleCacheFiles(const char* const cacheDirPath, const struct WallpaperKey* const key,
+                                  const char* const keptFileName) {
+    DIR* const dir = opendir(cacheDirPath);
+    if (dir == NULL) {
+        return;
+    }
+    char prefix[32];
+    snprintf(prefix, sizeof(prefix), "%ux%u-", key->width, key->height);
+    size_t const prefixLength = strlen(prefix);
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (strncmp(entry->d_name, prefix, prefixLength) == 0 && strcmp(entry->d_name, keptFileName) != 0) {
+            unlinkat(dirfd(dir), entry->d_name, 0);
+        }
+    }
+    closedir(dir);
+}
+
+static bool mapCachedWallpaper(struct Wallpaper* const wallpaper, const char* const cachePath,
+                               const struct WallpaperKey* const key, const char* const imagePath) {
+    int const fd = open(cachePath, O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    size_t const size = getCacheFileSize(key);
+    struct stat st;
+    void* mapping = NULL;
+    if (fstat(fd, &st) == 0 && (size_t)st.st_size == size) {
+        mapping = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+    if (mapping == NULL || mapping == MAP_FAILED) {
+        return false;
+    }
+    const struct WallpaperCacheHeader* const header = mapping;
+    if (memcmp(header->magic, WALLPAPER_MAGIC, sizeof(header->magic)) != 0 ||
+        header->version != WALLPAPER_VERSION ||
+        memcmp(&header->key, key, sizeof(*key)) != 0 ||
+        (key->pathLength > 0 && memcmp(header + 1, imagePath, key->pathLength) != 0)) {
+        munmap(mapping, size);
+        return false;
+    }
+    wallpaper->mapping = mapping;
+    wallpaper->mappingSize = size;
+    wallpaper->pixels = (const uint32_t*)((const char*)mapping + getPixelOffset(key));
+    return true;
+}
+
+// written next to the cache file and renamed over it, so a crash never leaves half a wallpaper behind
+static void writeCachedWallpaper(const char* const cachePath, const struct WallpaperKey* const key,
+                                 const char* const imagePath, const uint32_t* const pixels) {
+    char* const cacheDirPath = getCacheDirPath();
+    if (g_mkdir_with_parents(cacheDirPath, 0700) != 0) {
+        g_free(cacheDirPath);
+        return;
+    }
+
+    struct WallpaperCacheHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, WALLPAPER_MAGIC, sizeof(header.magic));
+    header.version = WALLPAPER_VERSION;
+    header.key = *key;
+    char const padding[4] = {0, 0, 0, 0};
+    size_t const paddingSize = getPixelOffset(key) - sizeof(header) - key->pathLength;
+    size_t const pixelCount = (size_t)key->width * key->height;
+
+    size_t const tempPathLength = strlen(cachePath) + 5;
+    char* const tempPath = malloc(tempPathLength);
+    snprintf(tempPath, tempPathLength, "%s.tmp", cachePath);
+    FILE* const file = fopen(tempPath, "wb");
+    if (file != NULL) {
+        bool written = fwrite(&header, sizeof(header), 1, file) == 1 &&
+                       (key->pathLength == 0 || fwrite(imagePath, key->pathLength, 1, file) == 1) &&
+                       (paddingSize == 0 || fwrite(padding, paddingSize, 1, file) == 1) &&
+                       fwrite(pixels, sizeof(uint32_t), pixelCount, file) == pixelCount;
+        written = fclose(file) == 0 && written;
+        if (written && rename(tempPath, cachePath) == 0) {
+            removeStaleCacheFiles(cacheDirPath, key, strrchr(cachePath, '/') + 1);
+        } else {
+            remove(tempPath);
+        }
+    }
+    free(tempPath);
+    g_free(cacheDirPath);
+}
+
+// drawing
+
+// scaled to cover the output and centered, the color shows through where the image is transparent
+static bool drawImage(uint32_t* const pixels, const struct WallpaperKey* const key, const char* const imagePath) {
+    GError* error = NULL;
+    GdkPixbuf* const image = gdk_pixbuf_new_from_file(imagePath, &error);
+    if (image == NULL) {
+        fprintf(stderr, "Cannot load wallpaper %s: %s\n", imagePath, error->message);
+        g_error_free(error);
+        return false;
+    }
+    // RGBA pixbuf rows are laid out like WLC_RGBA8888, so the pixbuf draws straight into pixels
+    GdkPixbuf* const target = gdk_pixbuf_new_from_data((guchar*)pixels, GDK_COLORSPACE_RGB, TRUE, 8,
+                                                       key->width, key->height, key->width * sizeof(uint32_t),
+                                                       NULL, NULL);
+    double const imageWidth = gdk_pixbuf_get_width(image);
+    double const imageHeight = gdk_pixbuf_get_height(image);
+    double scale = key->width / imageWidth;
+    if (key->height / imageHeight > scale) {
+        scale = key->height / imageHeight;
+    }
+    gdk_pixbuf_composite(image, target, 0, 0, key->width, key->height,
+                         (key->width - imageWidth * scale) / 2, (key->height - imageHeight * scale) / 2,
+                         scale, scale, GDK_INTERP_BILINEAR, 255);
+    g_object_unref(target);
+    g_object_unref(image);
+    return true;
+}
+
+static uint32_t* drawWallpaper(const struct WallpaperKey* const key, const char* const imagePath) {
+    size_t const pixelCount = (size_t)key->width * key->height;
+    uint32_t* const pixels = malloc(pixelCount * sizeof(uint32_t));
+    fillPixels(pixels, pixelCount, key->color);
+    if (imagePath != NULL) {
+        drawImage(pixels, key, imagePath);
+    }
+    return pixels;
+}
+
+// sharing
+
+struct Wallpaper* acquireWallpaper(uint32_t const width, uint32_t const height) {
+    for (struct Wallpaper* wallpaper = wallpapers; wallpaper != NULL; wallpaper = wallpaper->next) {
+        if (wallpaper->width == width && wallpaper->height == height) {
+            wallpaper->refCount++;
+            return wallpaper;
+        }
+    }
+
+    struct WallpaperKey key;
+    const char* const imagePath = getWallpaperKey(width, height, &key);
+    struct Wallpaper* const wallpaper = malloc(sizeof(struct Wallpaper));
+    *wallpaper = (struct Wallpaper){1, width, height, NULL, NULL, 0, wallpapers};
+    char* const cachePath = getCachePath(&key, imagePath);
+    if (!mapCachedWallpaper(wallpaper, cachePath, &key, imagePath)) {
+        uint32_t* const pixels = drawWallpaper(&key, imagePath);
+        writeCachedWallpaper(cachePath, &key, imagePath, pixels);
+        wallpaper->pixels = pixels;
+    }
+    g_free(cachePath);
+    wallpapers = wallpaper;
+    return wallpaper;
+}
+
+void releaseWallpaper(struct Wallpaper* const wallpaper) {
+    if (wallpaper == NULL || --wallpaper->refCount > 0) {
+        return;
+    }
+    struct Wallpaper** link = &wallpapers;
+    while (*link != wallpaper) {
+        link = &(*link)->next;
+    }
+    *link = wallpaper->next;
+    if (wallpaper->mapping != NULL) {
+        munmap(wallpaper->mapping, wallpaper->mappingSize);
+    } else {
+        free((uint32_t*)wallpaper->pixels);
+    }
+    free(wallpaper);
+}
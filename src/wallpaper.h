@@ -0,0 +1,24 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Wallpapers are shared by all outputs of the same resolution. The configured image is scaled to cover the output
+// and drawn over the wallpaper color once per resolution. The result is cached in WALLPAPER_CACHE_DIR, keyed by
+// the image's path, size and mtime, the color and the resolution, and mapped from there, so neither a new output
+// nor a restart decodes or fills it again.
+
+#define WALLPAPER_CACHE_DIR "endlesswm-wallpapers"  // in $XDG_CACHE_HOME, or ~/.cache if that's not set
+
+struct Wallpaper {
+    size_t refCount;
+    uint32_t width;
+    uint32_t height;
+    const uint32_t* pixels;  // WLC_RGBA8888
+    void* mapping;           // the cache file the pixels are mapped from, NULL if they're allocated
+    size_t mappingSize;
+    struct Wallpaper* next;
+};
+
+struct Wallpaper* acquireWallpaper(uint32_t width, uint32_t height);
+void releaseWallpaper(struct Wallpaper* wallpaper);  // NULL is ignored
@@ -0,0 +1,72 @@
+#include "wlcbackend.h"
+#include "metamanager.h"
+#include "mouse.h"
+#include "painting.h"
+
+#include <wlc/wlc.h>
+#include <wlc/wlc-render.h>
+
+// metadata
+
+static struct Grid* getOutputGrid(wlc_handle const output) {
+    return getOutput(output)->grid;
+}
+
+static struct Window* getViewWindow(wlc_handle const view) {
+    return getView(view)->window;
+}
+
+static void forgetViewWindow(wlc_handle const view) {
+    getView(view)->window = NULL;
+}
+
+// views
+
+static struct GridGeometry getViewGeometry(wlc_handle const view) {
+    const struct wlc_geometry* geom = wlc_view_get_geometry(view);
+    return (struct GridGeometry){{geom->origin.x, geom->origin.y}, {geom->size.w, geom->size.h}};
+}
+
+static struct GridGeometry getViewVisibleGeometry(wlc_handle const view) {
+    struct wlc_geometry geom;
+    wlc_view_get_visible_geometry(view, &geom);
+    return (struct GridGeometry){{geom.origin.x, geom.origin.y}, {geom.size.w, geom.size.h}};
+}
+
+static void setViewGeometry(wlc_handle const view, const struct GridGeometry* const geometry) {
+    struct wlc_geometry const geom = {{geometry->origin.x, geometry->origin.y}, {geometry->size.w, geometry->size.h}};
+    wlc_view_set_geometry(view, 0, &geom);
+    invalidateOverlays();  // applied in the frame's render_pre, so it's painted in the same frame
+}
+
+static void setViewMask(wlc_handle const view, uint32_t const mask) {
+    wlc_view_set_mask(view, mask);
+    invalidateOverlays();
+}
+
+// outputs
+
+static struct GridSize getOutputSize(wlc_handle const output) {
+    const struct wlc_size* resolution = wlc_output_get_virtual_resolution(output);
+    return (struct GridSize){resolution->w, resolution->h};
+}
+
+const struct GridBackend wlcBackend = {
+    .getGrid                = &getOutputGrid,
+    .getWindow              = &getViewWindow,
+    .forgetWindow           = &forgetViewWindow,
+    .getViewParent          = &wlc_view_get_parent,
+    .getViewOutput          = &wlc_view_get_output,
+    .getViewGeometry        = &getViewGeometry,
+    .getViewVisibleGeometry = &getViewVisibleGeometry,
+    .setViewGeometry        = &setViewGeometry,
+    .setViewMask            = &setViewMask,
+    .setViewOutput          = &wlc_view_set_output,
+    .focusView              = &wlc_view_focus,
+    .closeView              = &wlc_view_close,
+    .getOutputSize          = &getOutputSize,
+    .getFocusedOutput       = &wlc_get_focused_output,
+    .scheduleRender         = &wlc_output_schedule_render,
+    .getPointerPosition     = &wlc_pointer_get_position_v2,
+    .edgesInvalidated       = &mouseHandleEdgesInvalidated,
+};
@@ -0,0 +1,5 @@
+#pragma once
+
+#include "gridbackend.h"
+
+extern const struct GridBackend wlcBackend;  // drives the grid through wlc and the metamanager